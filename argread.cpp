@@ -2,7 +2,7 @@
 #include "argread.h"
 //#include <cstring>
 
-ArgRead argRead;
+thread_local ArgRead argRead;
 
 ArgRead::~ArgRead() {
     delete[] ar_options;
@@ -19,7 +19,9 @@ void ArgRead::AR_ReadArgs(int argc, char *argv[]) {
         ar_commandLine += string(" ") + argv[i];
     ar_numArguments = 1;
     ar_numRequired = 1;
-    ar_numOptions = 34;
+    ar_numOptions = 47;
+    delete[] ar_options;
+    delete[] ar_longOptions;
     ar_options = new charPtr[ar_numOptions];
     ar_longOptions = new charPtr[ar_numOptions];
     ar_options[0] = "wm";
@@ -30,66 +32,92 @@ void ArgRead::AR_ReadArgs(int argc, char *argv[]) {
     ar_longOptions[2] = "w";
     ar_options[3] = "v";
     ar_longOptions[3] = "v";
-    ar_options[4] = "sp";
-    ar_longOptions[4] = "sp";
-    ar_options[5] = "seed";
-    ar_longOptions[5] = "seed";
-    ar_options[6] = "plc";
-    ar_longOptions[6] = "plc";
-    ar_options[7] = "nw";
-    ar_longOptions[7] = "nw";
-    ar_options[8] = "nlc";
-    ar_longOptions[8] = "nlc";
-    ar_options[9] = "nfi";
-    ar_longOptions[9] = "nfi";
-    ar_options[10] = "mstf";
-    ar_longOptions[10] = "mstf";
-    ar_options[11] = "msb";
-    ar_longOptions[11] = "msb";
-    ar_options[12] = "mpl";
-    ar_longOptions[12] = "mpl";
-    ar_options[13] = "mipl";
-    ar_longOptions[13] = "mipl";
-    ar_options[14] = "mino";
-    ar_longOptions[14] = "mino";
-    ar_options[15] = "mini";
-    ar_longOptions[15] = "mini";
-    ar_options[16] = "log";
-    ar_longOptions[16] = "log";
-    ar_options[17] = "lcc";
-    ar_longOptions[17] = "lcc";
-    ar_options[18] = "iw";
-    ar_longOptions[18] = "iw";
-    ar_options[19] = "fip";
-    ar_longOptions[19] = "fip";
-    ar_options[20] = "fic";
-    ar_longOptions[20] = "fic";
-    ar_options[21] = "f";
-    ar_longOptions[21] = "f";
-    ar_options[22] = "eg";
-    ar_longOptions[22] = "eg";
-    ar_options[23] = "eP";
-    ar_longOptions[23] = "eP";
-    ar_options[24] = "dtc";
-    ar_longOptions[24] = "dtc";
-    ar_options[25] = "dsd";
-    ar_longOptions[25] = "dsd";
-    ar_options[26] = "dgc";
-    ar_longOptions[26] = "dgc";
-    ar_options[27] = "dct";
-    ar_longOptions[27] = "dct";
-    ar_options[28] = "dbf";
-    ar_longOptions[28] = "dbf";
-    ar_options[29] = "d";
-    ar_longOptions[29] = "d";
-    ar_options[30] = "cms";
-    ar_longOptions[30] = "cms";
-    ar_options[31] = "ap";
-    ar_longOptions[31] = "ap";
-    ar_options[32] = "al";
-    ar_longOptions[32] = "al";
-    ar_options[33] = "2p";
-    ar_longOptions[33] = "2p";
+    ar_options[4] = "trace";
+    ar_longOptions[4] = "trace";
+    ar_options[5] = "sweep";
+    ar_longOptions[5] = "sweep";
+    ar_options[6] = "sp";
+    ar_longOptions[6] = "sp";
+    ar_options[7] = "so";
+    ar_longOptions[7] = "so";
+    ar_options[8] = "server";
+    ar_longOptions[8] = "server";
+    ar_options[9] = "seed";
+    ar_longOptions[9] = "seed";
+    ar_options[10] = "resume";
+    ar_longOptions[10] = "resume";
+    ar_options[11] = "pmi";
+    ar_longOptions[11] = "pmi";
+    ar_options[12] = "plc";
+    ar_longOptions[12] = "plc";
+    ar_options[13] = "perf";
+    ar_longOptions[13] = "perf";
+    ar_options[14] = "od";
+    ar_longOptions[14] = "od";
+    ar_options[15] = "nw";
+    ar_longOptions[15] = "nw";
+    ar_options[16] = "nlc";
+    ar_longOptions[16] = "nlc";
+    ar_options[17] = "nfi";
+    ar_longOptions[17] = "nfi";
+    ar_options[18] = "mstf";
+    ar_longOptions[18] = "mstf";
+    ar_options[19] = "msb";
+    ar_longOptions[19] = "msb";
+    ar_options[20] = "mpl";
+    ar_longOptions[20] = "mpl";
+    ar_options[21] = "mipl";
+    ar_longOptions[21] = "mipl";
+    ar_options[22] = "mino";
+    ar_longOptions[22] = "mino";
+    ar_options[23] = "mini";
+    ar_longOptions[23] = "mini";
+    ar_options[24] = "log";
+    ar_longOptions[24] = "log";
+    ar_options[25] = "lcc";
+    ar_longOptions[25] = "lcc";
+    ar_options[26] = "j";
+    ar_longOptions[26] = "j";
+    ar_options[27] = "iw";
+    ar_longOptions[27] = "iw";
+    ar_options[28] = "fip";
+    ar_longOptions[28] = "fip";
+    ar_options[29] = "fic";
+    ar_longOptions[29] = "fic";
+    ar_options[30] = "f";
+    ar_longOptions[30] = "f";
+    ar_options[31] = "eg";
+    ar_longOptions[31] = "eg";
+    ar_options[32] = "eP";
+    ar_longOptions[32] = "eP";
+    ar_options[33] = "dtc";
+    ar_longOptions[33] = "dtc";
+    ar_options[34] = "dsd";
+    ar_longOptions[34] = "dsd";
+    ar_options[35] = "dry";
+    ar_longOptions[35] = "dry";
+    ar_options[36] = "dgc";
+    ar_longOptions[36] = "dgc";
+    ar_options[37] = "dct";
+    ar_longOptions[37] = "dct";
+    ar_options[38] = "dbf";
+    ar_longOptions[38] = "dbf";
+    ar_options[39] = "d";
+    ar_longOptions[39] = "d";
+    ar_options[40] = "cpi";
+    ar_longOptions[40] = "cpi";
+    ar_options[41] = "cms";
+    ar_longOptions[41] = "cms";
+    ar_options[42] = "checkpoint";
+    ar_longOptions[42] = "checkpoint";
+    ar_options[43] = "cache";
+    ar_longOptions[43] = "cache";
+    ar_options[44] = "ap";
+    ar_longOptions[44] = "ap";
+    ar_options[45] = "al";
+    ar_longOptions[45] = "al";
+    ar_options[46] = "2p";
+    ar_longOptions[46] = "2p";
 
     //Set defaults:
     allowLongPaths = 0;
@@ -119,11 +147,29 @@ void ArgRead::AR_ReadArgs(int argc, char *argv[]) {
     debugBits_set = 0;
     minSigmaTFactor = 2.0;
     showProgress = 0;
+    statisticsOnly = 0;
+    dryRun = 0;
+    perfCounters = 0;
+    sweepFile = "";
+    traceFile = "";
+    numThreads = 0;
+    parallelMacrocells = 0;
+    cacheDir = "";
+    checkpointDir = "";
+    outputDir = "";
+    serverSocket = "";
+    checkpointInterval = 300;
+    resume = 0;
     writeAllModules = 0;
     verboseMode = 0;
     meanTCorrectionFactor = 0.2;
     dontInsertFlops = 0;
     //Compile regular expressions for float and int
+    if (compiledEx) {
+        regfree(&floatEx);
+        regfree(&intEx);
+        compiledEx = 0;
+    }
     if (regcomp(&intEx, "^[\\+\\-]{0,1}[0-9]+$", REG_EXTENDED))
         throw ("Cannot compile regular expression for integers");
     if (regcomp(&floatEx, "^[\\+-]{0,1}[0-9]*(\\.[0-9]+){0,1}$", REG_EXTENDED))
@@ -137,7 +183,7 @@ void ArgRead::AR_ReadArgs(int argc, char *argv[]) {
     int argCounter = 0;
     try {
         AR_OptionsAndArguments(arguments, argCounter);
-        if (argCounter < ar_numRequired)
+        if (argCounter < ar_numRequired && serverSocket.empty())
             throw (argCounter);
     }
     catch (int count) {
@@ -448,109 +494,148 @@ void ArgRead::AR_Argument::PrintPosition() {
 
 void ArgRead::AR_ReadOption(int num, int &argCounter) {
     switch (num) {
-        case 4:
+        case 6:
             showProgress = 1;
             break;
-        case 10:
+        case 18:
             AR_ReadFloat(minSigmaTFactor, lower, 0, 0);
             break;
         case 1:
             writeAllModules = 1;
             break;
-        case 25:
+        case 34:
             AR_ReadMultipleFloat(delayShapeDistribution, lower, 0, 0);
             break;
-        case 12:
+        case 20:
             AR_ReadFloat(maxPathLength, lower, 0, 0);
             break;
-        case 6:
+        case 12:
             AR_ReadFloat(pathLengthCutOff, both, 0, 100);
             break;
-        case 16:
+        case 24:
             AR_ReadString(logFileName, none, 0, 0);
             break;
-        case 29:
+        case 39:
             AR_ReadInt(debugBits, none, 0, 0);
             debugBits_set = 1;
             break;
         case 3:
             verboseMode = 1;
             break;
-        case 24:
+        case 33:
             AR_ReadFloat(meanTCorrectionFactor, lower, 0, 0);
             break;
-        case 9:
+        case 17:
             dontInsertFlops = 1;
             break;
-        case 11:
+        case 19:
             AR_ReadInt(minSeqBlocks, lower, 0, 0);
             break;
-        case 20:
+        case 29:
             AR_ReadFloat(flopCutOff, both, 0, 100);
             break;
-        case 7:
+        case 15:
             noWarnings = 1;
             break;
-        case 27:
+        case 37:
             AR_ReadInt(correctionThreshold, lower, 1, 0);
             break;
         case 0:
-            AR_ReadMultipleRegEx(outputMacrocellFormats, "hnl|netD|netD2|nets|info|plot|rtd|dat|tree|ptree");
+            AR_ReadMultipleRegEx(outputMacrocellFormats, "hnl|netD|netD2|nets|shm|info|plot|rtd|dat|tree|ptree");
             break;
-        case 23:
+        case 32:
             AR_ReadFloat(maxPinError, both, 0, 100);
             break;
-        case 28:
+        case 38:
             AR_ReadFloat(correctionBucketFactor, lower, 1, 0);
             break;
-        case 17:
+        case 25:
             AR_ReadFloat(localConnectionCutOff, both, 0, 100);
             break;
-        case 14:
+        case 22:
             AR_ReadInt(minimumOutputs, lower, 0, 0);
             break;
-        case 31:
+        case 44:
             allowLongPaths = 1;
             break;
-        case 15:
+        case 23:
             AR_ReadInt(minimumInputs, lower, 0, 0);
             break;
-        case 22:
+        case 31:
             AR_ReadFloat(maxFracError, both, 0, 100);
             break;
-        case 5:
+        case 9:
             AR_ReadInt(seed, none, 0, 0);
             break;
-        case 33:
+        case 46:
             twoPointNets = 1;
             break;
-        case 21:
+        case 30:
             AR_ReadFile(argCounter);
             break;
         case 2:
-            AR_ReadMultipleRegEx(outputFormats, "hnl|netD|netD2|nets|info|plot|rtd|dat|tree|ptree");
+            AR_ReadMultipleRegEx(outputFormats, "hnl|netD|netD2|nets|shm|info|plot|rtd|dat|tree|ptree|json");
             break;
-        case 19:
+        case 28:
             AR_ReadFloat(flopInsertProbability, both, 0, 1);
             break;
-        case 32:
+        case 45:
             allowLoops = 1;
             break;
-        case 8:
+        case 16:
             noLocalConnections = 1;
             break;
-        case 30:
+        case 41:
             combineAccordingToSize = 1;
             break;
-        case 18:
+        case 27:
             areaAsWeight = 1;
             break;
-        case 13:
+        case 21:
             AR_ReadFloat(minPathLength, lower, 0, 0);
             break;
-        case 26:
+        case 36:
             AR_ReadFloat(meanGCorrectionFactor, lower, 0, 0);
             break;
+        case 7:
+            statisticsOnly = 1;
+            break;
+        case 5:
+            AR_ReadString(sweepFile, none, 0, 0);
+            break;
+        case 26:
+            AR_ReadInt(numThreads, lower, 0, 0);
+            break;
+        case 35:
+            dryRun = 1;
+            break;
+        case 4:
+            AR_ReadString(traceFile, none, 0, 0);
+            break;
+        case 13:
+            perfCounters = 1;
+            break;
+        case 11:
+            parallelMacrocells = 1;
+            break;
+        case 43:
+            AR_ReadString(cacheDir, none, 0, 0);
+            break;
+        case 42:
+            AR_ReadString(checkpointDir, none, 0, 0);
+            break;
+        case 40:
+            AR_ReadInt(checkpointInterval, lower, 0, 0);
+            break;
+        case 10:
+            resume = 1;
+            break;
+        case 14:
+            AR_ReadString(outputDir, none, 0, 0);
+            break;
+        case 8:
+            AR_ReadString(serverSocket, none, 0, 0);
+            break;
     }
 }
 
@@ -572,12 +657,28 @@ void ArgRead::AR_ReadArgument(int &argCounter) {
 void ArgRead::AR_Usage() {
     cout << ""
             "Usage: gnl [options] <XX.gnl>\n"
+            "       gnl -server <socket> [-j <threads>]\n"
             "  options: \n"
             "     general options:\n"
             "	f		Options & arguments file\n"
             "	v		Verbose mode on\n"
             "	d <level>	Debug mode on\n"
             "	log <file>	Log filename\n"
+            "	trace <file>	Write a binary trace of the combinations (decode with gnltrace)\n"
+            "	sweep <file>	Run the parameter sweep in <file>, results in <circuit>.sweep\n"
+            "	j <threads>	Number of threads for the sweep and -pmi [number of cores]\n"
+            "	pmi		Pre-generate the macrocell instances in parallel (own seed\n"
+            "			per instance, independent of the number of threads)\n"
+            "	cache <dir>	Keep the pre-generated macrocell instances in <dir> and\n"
+            "			reuse them in later runs (implies -pmi)\n"
+            "	checkpoint <dir>	Write checkpoints of the generation of the circuit to <dir>\n"
+            "	cpi <seconds>	Time between checkpoints [300]\n"
+            "	resume		Continue from the checkpoint in the -checkpoint directory\n"
+            "	server <socket>	Serve generation requests on a Unix socket, with -j threads\n"
+            "			(send them with gnlclient; no gnl file)\n"
+            "	dry		Dry run: estimate blocks, memory and file sizes only\n"
+            "	perf		Count cycles, instructions and cache and branch misses per\n"
+            "			phase (json report, needs perf_event_open)\n"
             "\n"
             "     generation options:\n"
             "	sp		Show progress\n"
@@ -586,10 +687,13 @@ void ArgRead::AR_Usage() {
             "	eg <%error>	Warn if error on final output fraction too big [20]\n"
             "\n"
             "     output options:\n"
-            "	w <formats>	Output formats (hnl,netD,netD2,nets,info,plot,rtd,dat,tree,\n"
-            "			ptree) [hnl]\n"
+            "	w <formats>	Output formats (hnl,netD,netD2,nets,shm,info,plot,rtd,dat,\n"
+            "			tree,ptree,json) [hnl]\n"
             "	wm <formats>	Output formats for internal macrocells\n"
             "	wa		Write output for all modules (-wm identical to -w)\n"
+            "	od <dir>	Directory for the output files [.]\n"
+            "	so		Statistics only: simulate combinations at the pin count\n"
+            "			level, no netlist (info,plot,rtd,dat,ptree) [rtd,dat]\n"
             "\n"
             "     loop and delay parameters:\n"
             "	mpl		Maximum path length [40]\n"
@@ -597,7 +701,7 @@ void ArgRead::AR_Usage() {
             "	dsd		Delay shape distribution [ 0 .. 0 1 ]\n"
             "	msb		Minimum number of blocks for sequential combination [0]\n"
             "	mipl		Minimum path length [0]\n"
-            "	ap		Allow long paths\n"
+            "	ap		Allow long paths (loops are still avoided)\n"
             "	al		Allow combinational loops (this implies -ap)\n"
             "\n"
             "     parameters for improved control:\n"
@@ -28,9 +28,9 @@ typedef char *charPtr;
 
 class ArgRead {
 public:
-    ArgRead() : compiledEx(0) {}
+    ArgRead() : ar_options(0), ar_longOptions(0), compiledEx(0) {}
 
-    ArgRead(int argc, char *argv[]) : compiledEx(0) { AR_ReadArgs(argc, argv); }
+    ArgRead(int argc, char *argv[]) : ar_options(0), ar_longOptions(0), compiledEx(0) { AR_ReadArgs(argc, argv); }
 
     ~ArgRead();
 
@@ -73,6 +73,19 @@ public:
     bool debugBits_set;
     float minSigmaTFactor;
     bool showProgress;
+    bool statisticsOnly;
+    bool dryRun;
+    bool perfCounters;
+    string sweepFile;
+    string traceFile;
+    int numThreads;
+    bool parallelMacrocells;
+    string cacheDir;
+    string checkpointDir;
+    int checkpointInterval;
+    bool resume;
+    string outputDir;
+    string serverSocket;
     bool writeAllModules;
     list<float> delayShapeDistribution;
     bool verboseMode;
@@ -151,6 +164,6 @@ private:
     } ar_argument;
 };
 
-extern ArgRead argRead;
+extern thread_local ArgRead argRead;
 
 #endif
\ No newline at end of file
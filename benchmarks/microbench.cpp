@@ -0,0 +1,370 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+//gnlbench: microbenchmarks for the kernels of the combine hot path
+//
+//  gnlbench [<filter>]
+//
+//runs the benchmarks whose name contains <filter> (default: all) on synthetic inputs of the given
+//sizes and writes one line per benchmark and size: name, size, number of operations timed and the
+//time per operation in ns (the best of three runs). The inputs are generated with a fixed seed, so
+//the figures can be compared across commits. Configure with -DCMAKE_BUILD_TYPE=Release to measure
+//optimized code.
+
+#include "main.h"
+#include "argread.h"
+#include "pvtools.h"
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+
+class MicroBenchmark {
+public:
+    MicroBenchmark(const string &f);
+
+    ~MicroBenchmark();
+
+    void Run();
+
+private:
+    //a kernel performs at least the given number of operations and returns the number it performed,
+    //together with the time spent in the timed part (setup and cleanup are not timed)
+    typedef long (MicroBenchmark::*Kernel)(int size, long operations, double &seconds);
+
+    void Measure(const char *name, int size, Kernel kernel);
+
+    long Combine(int size, long operations, double &seconds);
+
+    long OutputNetJoin(int size, long operations, double &seconds);
+
+    long InputNetJoin(int size, long operations, double &seconds);
+
+    long RandomizeList(int size, long operations, double &seconds);
+
+    long GetIO(int size, long operations, double &seconds);
+
+    long DelaySample(int size, long operations, double &seconds);
+
+    long CounterMapLookup(int size, long operations, double &seconds);
+
+    Module *BuildModule(int size);
+
+    Librarycell *RandomCell();
+
+    static double Seconds(chrono::steady_clock::time_point start);
+
+    string filter;
+    string specFile;
+    vector<Librarycell *> cells;
+    ModuleType *circuit;
+
+    static const int circuitSize = 8192;
+    static const int repeats = 3;
+    static const int batchSize = 1024;  //operations set up at once, bounds the memory of the fast kernels
+    static constexpr double minTime = 0.05;  //a run is long enough to time when it takes this many seconds
+    static constexpr double maxRunTime = 0.5;  //or when it takes this many seconds including the setup
+};
+
+MicroBenchmark::MicroBenchmark(const string &f) : filter(f) {
+    lout.SetDestination(Log::none);
+    tempdir.MakeDir();
+    specFile = tempdir.Name() + "/bench.gnl";
+    ofstream spec(specFile.c_str());
+    spec << "[library]\n"
+            "name=lib\n"
+            "gate=inv 1 1\n"
+            "gate=nand2 2 1\n"
+            "gate=nand3 3 1\n"
+            "gate=nor2 2 1\n"
+            "latch=dff 1 1\n"
+            "\n"
+            "[circuit]\n"
+            "name=bench\n"
+            "libraries=lib\n"
+            "distribution=1310 3277 983 1638 984\n"
+            "size=1\n"
+            "p=0.6\n"
+            "size=" << circuitSize << "\n"
+            "I=120\n"
+            "O=80\n";
+    spec.close();
+
+    const char *argv[] = {"gnlbench", specFile.c_str()};
+    argRead.AR_ReadArgs(2, (char **) argv);
+    InitializeGenerator();
+    ParseGnlFile();
+    circuit = Globals::circuit;
+    list<Cell *> &libraryCells = Globals::libraries["lib"].cells;
+    for (list<Cell *>::iterator ci = libraryCells.begin(); ci != libraryCells.end(); ++ci)
+        cells.push_back(dynamic_cast<Librarycell *>(*ci));
+}
+
+MicroBenchmark::~MicroBenchmark() {
+    Globals::Clear();
+}
+
+void MicroBenchmark::Run() {
+    printf("%-20s %8s %12s %12s\n", "benchmark", "size", "operations", "ns/op");
+    int moduleSizes[] = {1, 16, 256, 4096};
+    for (int i = 0; i < 4; ++i)
+        Measure("combine", moduleSizes[i], &MicroBenchmark::Combine);
+    for (int i = 1; i < 4; ++i)
+        Measure("outputnet-join", moduleSizes[i], &MicroBenchmark::OutputNetJoin);
+    for (int i = 0; i < 4; ++i)
+        Measure("inputnet-join", moduleSizes[i], &MicroBenchmark::InputNetJoin);
+    for (int i = 1; i < 4; ++i)
+        Measure("randomize-list", moduleSizes[i], &MicroBenchmark::RandomizeList);
+    int ioSizes[] = {2, 64, 4096};
+    for (int i = 0; i < 3; ++i)
+        Measure("getio", ioSizes[i], &MicroBenchmark::GetIO);
+    int shapeSizes[] = {2, 16, 256};
+    for (int i = 0; i < 3; ++i)
+        Measure("delay-sample", shapeSizes[i], &MicroBenchmark::DelaySample);
+    int mapSizes[] = {16, 256, 4096, 65536};
+    for (int i = 0; i < 4; ++i)
+        Measure("countermap", mapSizes[i], &MicroBenchmark::CounterMapLookup);
+}
+
+void MicroBenchmark::Measure(const char *name, int size, Kernel kernel) {
+    if (!filter.empty() && string(name).find(filter) == string::npos)
+        return;
+    //every benchmark starts from the same random state, independent of the ones run before it
+    randomSeed(argRead.seed);
+    //double the number of operations until a run takes long enough, or its setup takes too long
+    long operations = 1, done;
+    double seconds;
+    for (;;) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        done = (this->*kernel)(size, operations, seconds);
+        if (!done || seconds >= minTime || Seconds(start) >= maxRunTime)
+            break;
+        operations = 2 * done;
+    }
+    double best = done ? seconds / done : 0;
+    for (int r = 1; r < repeats && done; ++r) {
+        long n = (this->*kernel)(size, operations, seconds);
+        if (n && seconds / n < best)
+            best = seconds / n;
+    }
+    printf("%-20s %8d %12ld %12.1f\n", name, size, done, best * 1e9);
+    fflush(stdout);
+}
+
+double MicroBenchmark::Seconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+Librarycell *MicroBenchmark::RandomCell() {
+    return cells[randomNumber(cells.size())];
+}
+
+//a module of the given number of blocks, built like a balanced partition tree
+Module *MicroBenchmark::BuildModule(int size) {
+    if (size == 1)
+        return new Module(RandomCell());
+    return new Module(BuildModule(size / 2), BuildModule(size - size / 2), circuit);
+}
+
+//Module::Module(modA, modB, modType) on two modules of size blocks each
+long MicroBenchmark::Combine(int size, long operations, double &seconds) {
+    seconds = 0;
+    long done = 0;
+    while (done < operations) {
+        long n = min(long(max(1, batchSize / size)), operations - done);
+        vector<Module *> modules(2 * n);
+        for (long i = 0; i < 2 * n; ++i)
+            modules[i] = BuildModule(size);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (long i = 0; i < n; ++i)
+            modules[i] = new Module(modules[2 * i], modules[2 * i + 1], circuit);
+        seconds += Seconds(start);
+        for (long i = 0; i < n; ++i)
+            delete modules[i];
+        Globals::treeData.clear();
+        done += n;
+    }
+    return done;
+}
+
+//OutputNet::Join attempts as made in phase 4: every output of a module of size blocks to its own inputs
+long MicroBenchmark::OutputNetJoin(int size, long operations, double &seconds) {
+    double delayScaleFactor = min(1.0, log(double(size)) /
+                                       (argRead.pathLengthCutOff * log(double(circuit->Size())) / 100));
+    seconds = 0;
+    long done = 0;
+    while (done < operations) {
+        Module *module = BuildModule(size);
+        long attempts = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        list<Module::InputNet *>::iterator ii = module->inputs.begin();
+        list<Module::OutputNet *>::iterator oi = module->outputs.begin();
+        while (oi != module->outputs.end() && ii != module->inputs.end()) {
+            ++attempts;
+            if ((*oi)->Join(*ii, module, 0, module, delayScaleFactor, circuit)) {
+                ++oi;
+                module->inputs.erase(ii);
+                ii = module->inputs.begin();
+            } else if (++ii == module->inputs.end()) {
+                ii = module->inputs.begin();
+                ++oi;
+            }
+        }
+        seconds += Seconds(start);
+        delete module;
+        Globals::treeData.clear();
+        if (!attempts)
+            return 0;
+        done += attempts;
+    }
+    return done;
+}
+
+//InputNet::Join of two nets that have the same size controllable outputs
+long MicroBenchmark::InputNetJoin(int size, long operations, double &seconds) {
+    Librarycell *cell = cells.front();
+    Module::Block block(cell);
+    vector<Module::OutputNet *> outputs(size);
+    for (int i = 0; i < size; ++i)
+        outputs[i] = new Module::OutputNet(0);
+    Module owner(cell);
+    Module::InputNet *target = new Module::InputNet(0, argRead.maxPathLength);
+    target->sinks.push_back(Module::Terminal(&block, 0));
+    for (int i = 0; i < size; ++i)
+        target->controllableOutputs.Insert(outputs[i], uniform(0, argRead.maxPathLength));
+
+    seconds = 0;
+    long done = 0;
+    while (done < operations) {
+        long n = min(long(max(1, batchSize * 16 / size)), operations - done);
+        vector<Module::InputNet *> nets(n);
+        for (long j = 0; j < n; ++j) {
+            nets[j] = new Module::InputNet(0, argRead.maxPathLength);
+            nets[j]->sinks.push_back(Module::Terminal(&block, 0));
+            for (int i = 0; i < size; ++i)
+                nets[j]->controllableOutputs.Insert(outputs[i], uniform(0, argRead.maxPathLength));
+        }
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (long j = 0; j < n; ++j)
+            target->Join(nets[j], &owner);
+        seconds += Seconds(start);
+        done += n;
+    }
+
+    delete target;
+    for (int i = 0; i < size; ++i)
+        delete outputs[i];
+    return done;
+}
+
+//randomizeList on a list of size elements
+long MicroBenchmark::RandomizeList(int size, long operations, double &seconds) {
+    list<int> l;
+    for (int i = 0; i < size; ++i)
+        l.push_back(i);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long n = 0; n < operations; ++n)
+        randomizeList(l);
+    seconds = Seconds(start);
+    return operations;
+}
+
+//ModuleType::GetIO for a module of size blocks
+long MicroBenchmark::GetIO(int size, long operations, double &seconds) {
+    int i, o;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long n = 0; n < operations; ++n)
+        circuit->GetIO(size, i, o);
+    seconds = Seconds(start);
+    return operations;
+}
+
+//DelayDistrib::Sample on a delay shape of size points
+long MicroBenchmark::DelaySample(int size, long operations, double &seconds) {
+    list<float> shape;
+    for (int i = 0; i < size; ++i)
+        shape.push_back(1 + i % 7);
+    DelayDistrib delays;
+    delays.InitShape(argRead.maxPathLength, shape);
+    double sum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long n = 0; n < operations; ++n)
+        sum += delays.Sample();
+    seconds = Seconds(start);
+    if (sum < 0)
+        throw ("Internal error: negative delay");
+    return operations;
+}
+
+//CounterMap::operator[]: numbering size pointers in random order, then looking them up again
+long MicroBenchmark::CounterMapLookup(int size, long operations, double &seconds) {
+    vector<int> objects(size);
+    vector<void *> pointers(size);
+    for (int i = 0; i < size; ++i)
+        pointers[i] = &objects[i];
+    for (int i = size - 1; i > 0; --i)
+        swap(pointers[i], pointers[randomNumber(i + 1)]);
+
+    seconds = 0;
+    long done = 0;
+    long sum = 0;
+    while (done < operations) {
+        CounterMap counterMap;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int pass = 0; pass < 2; ++pass)
+            for (int i = 0; i < size; ++i)
+                sum += counterMap[pointers[i]];
+        seconds += Seconds(start);
+        done += 2 * size;
+    }
+    if (sum < 0)
+        throw ("Internal error: negative counter");
+    return done;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        cerr << "Usage: gnlbench [<filter>]\n";
+        return 1;
+    }
+    try {
+        MicroBenchmark benchmark(argc == 2 ? argv[1] : "");
+        benchmark.Run();
+    }
+    catch (const char *s) {
+        cerr << s << "\n";
+        return 1;
+    }
+    catch (string &s) {
+        cerr << s << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+# scaling.gp: plot the results of scaling.sh
+#
+#   gnuplot -e "dir='<output dir>'; formats='<formats>'" benchmarks/scaling.gp
+#
+# writes <output dir>/time.svg, memory.svg and files.svg. Every quantity is divided by the number of
+# generated blocks, so linear scaling shows as a flat curve and super-linear behavior as a rising one.
+
+if (!exists("dir")) dir = "scaling"
+if (!exists("formats")) formats = "hnl netD nets"
+data = dir."/scaling.dat"
+variants = "comb seq hier"
+
+set terminal svg size 800,600 dynamic
+set logscale x
+set grid
+set key top left
+set xlabel "blocks"
+set datafile missing "NA"
+
+set output dir."/time.svg"
+set ylabel "wall time per block [us]"
+plot for [v in variants] data using (strcol(1) eq v ? $2 : NaN):($4 / $3 * 1e6) with linespoints title v
+
+set output dir."/memory.svg"
+set ylabel "peak memory per block [bytes]"
+plot for [v in variants] data using (strcol(1) eq v ? $2 : NaN):($5 / $3) with linespoints title v, \
+     for [v in variants] data using (strcol(1) eq v ? $2 : NaN):($6 / $3) with lines dashtype 2 title v." (estimate)"
+
+set output dir."/files.svg"
+set ylabel "output bytes per block"
+plot for [i = 7 : 6 + words(formats)] for [v in variants] \
+     data using (strcol(1) eq v ? $2 : NaN):(column(i) / $3) with linespoints title v." ".word(formats, i - 6)
@@ -0,0 +1,162 @@
+#!/bin/bash
+#
+# scaling.sh: measure how the generator scales with the circuit size
+#
+#   scaling.sh [-g <gnl binary>] [-o <output dir>] [-m <max blocks>] [-w "<formats>"] [-v "<variants>"]
+#
+# For every variant and size a spec is generated in <output dir>/<variant>-<blocks>/ and the
+# generator is run on it with the given output formats (default: hnl netD nets). The results are
+# collected in <output dir>/scaling.dat, one line per run:
+#
+#   variant blocks generated_blocks wall_seconds peak_rss_bytes estimated_bytes <bytes per format>...
+#
+# estimated_bytes is the peak memory predicted by gnl -dry. Runs whose upper bound estimate does
+# not fit in the available memory are skipped (NA). Plot the curves with
+#
+#   gnuplot -e "dir='<output dir>'; formats='<formats>'" benchmarks/scaling.gp
+#
+# variants:
+#   comb  a flat circuit of combinational gates with a few flip-flops
+#   seq   a flat circuit where a third of the blocks are flip-flops (two latch types)
+#   hier  a circuit with half its blocks in 8 instances of a [module]
+
+GNL=$(dirname "$0")/../_gate_build/GNL
+OUT=scaling
+MAX=1000000
+FORMATS="hnl netD nets"
+VARIANTS="comb seq hier"
+SIZES="10000 30000 100000 300000 1000000 3000000 10000000 30000000 100000000"
+
+while getopts "g:o:m:w:v:" opt; do
+    case $opt in
+        g) GNL=$OPTARG ;;
+        o) OUT=$OPTARG ;;
+        m) MAX=$OPTARG ;;
+        w) FORMATS=$OPTARG ;;
+        v) VARIANTS=$OPTARG ;;
+        *) sed -n '3,5p' "$0" >&2; exit 1 ;;
+    esac
+done
+GNL=$(realpath "$GNL") || exit 1
+mkdir -p "$OUT" || exit 1
+
+# write a [library] section; $1: library name, $2: "seq" for the sequential library
+library() {
+    echo "[library]"
+    echo "name=$1"
+    echo "gate=inv 1 1"
+    echo "gate=nand2 2 1"
+    echo "gate=nand3 3 1"
+    echo "gate=nor2 2 1"
+    echo "latch=dff 1 1"
+    [ "$2" = seq ] && echo "latch=dffr 2 1"
+    echo
+}
+
+# split $1 blocks over the fractions $2... (the last one gets the remainder)
+distribution() {
+    awk -v n="$1" 'BEGIN { left = n; for (i = 1; i < ARGC; ++i) { c = (i == ARGC - 1) ? left : int(n * ARGV[i] + 0.5); left -= c; printf "%s%d", (i > 1 ? " " : ""), c } print "" }' "${@:2}"
+}
+
+# size regions for a module of $1 blocks, with a Rent exponent of 0.6
+regions() {
+    awk -v n="$1" 'BEGIN { t = n ^ 0.6; printf "size=1\np=0.6\nsize=%d\nI=%d\nO=%d\n", n, int(0.6 * t + 0.5), int(0.4 * t + 0.5) }'
+}
+
+# write the spec of variant $1 with $2 blocks
+spec() {
+    case $1 in
+    comb)
+        library lib
+        echo "[circuit]"
+        echo "name=comb"
+        echo "libraries=lib"
+        echo "distribution=$(distribution "$2" 0.16 0.40 0.12 0.20 0.12)"
+        regions "$2"
+        ;;
+    seq)
+        library lib seq
+        echo "[circuit]"
+        echo "name=seq"
+        echo "libraries=lib"
+        echo "distribution=$(distribution "$2" 0.10 0.30 0.10 0.17 0.23 0.10)"
+        regions "$2"
+        ;;
+    hier)
+        local sub=$(($2 / 16)) top=$(($2 - 8 * ($2 / 16)))
+        library lib
+        echo "[module]"
+        echo "name=sub"
+        echo "libraries=lib"
+        echo "distribution=$(distribution $sub 0.16 0.40 0.12 0.20 0.12)"
+        regions $sub
+        echo
+        echo "[circuit]"
+        echo "name=hier"
+        echo "libraries=lib sub"
+        echo "distribution=$(distribution $top 0.16 0.40 0.12 0.20 0.12) 8"
+        regions "$2"
+        ;;
+    esac
+}
+
+# convert "<value> <unit>" as printed by gnl -dry to bytes
+bytes() {
+    awk -v v="$1" -v u="$2" 'BEGIN { f = (u ~ /^kB/) ? 1024 : (u ~ /^MB/) ? 1048576 : (u ~ /^GB/) ? 1073741824 : 1; printf "%.0f\n", v * f }'
+}
+
+# read a number from the json run report
+json() {
+    sed -n "s/^ *\"$2\": \([0-9.e+-]*\).*/\1/p" "$1" | head -1
+}
+
+available=$(awk '/^MemAvailable:/ { printf "%.0f\n", $2 * 1024 }' /proc/meminfo)
+result=$OUT/scaling.dat
+echo "# variant blocks generated_blocks wall_seconds peak_rss_bytes estimated_bytes $(for f in $FORMATS; do printf "%s_bytes " $f; done)" >"$result"
+
+for variant in $VARIANTS; do
+    for size in $SIZES; do
+        [ "$size" -gt "$MAX" ] && continue
+        dir=$OUT/$variant-$size
+        rm -rf "$dir" && mkdir -p "$dir" || exit 1
+        spec $variant $size >"$dir/$variant.gnl"
+
+        #estimate first, and skip the runs that would not fit in memory
+        estimate=$(cd "$dir" && "$GNL" -dry $variant.gnl | awk '/^   total:/ && !done { print $2, $3, $6, $7; done = 1 }')
+        set -- $estimate
+        estimated=$(bytes $1 $2)
+        upper=$(bytes $3 $4)
+        if [ -n "$available" ] && awk -v u="$upper" -v a="$available" 'BEGIN { exit !(u > a) }'; then
+            echo "$variant $size: skipped, estimated memory $upper bytes exceeds the available $available bytes" >&2
+            echo "$variant $size NA NA NA $estimated $(for f in $FORMATS; do printf "NA "; done)" >>"$result"
+            continue
+        fi
+
+        echo "$variant $size: running" >&2
+        start=$(date +%s.%N)
+        (cd "$dir" && "$GNL" -nw -log gnl.log -w $FORMATS json $variant.gnl >/dev/null 2>&1)
+        status=$?
+        end=$(date +%s.%N)
+        if [ $status -ne 0 ] || [ ! -f "$dir/$variant.json" ]; then
+            echo "$variant $size: failed, see $dir/gnl.log" >&2
+            echo "$variant $size NA NA NA $estimated $(for f in $FORMATS; do printf "NA "; done)" >>"$result"
+            continue
+        fi
+
+        line="$variant $size $(json "$dir/$variant.json" blocks) $(awk -v s="$start" -v e="$end" 'BEGIN { printf "%.3f", e - s }')"
+        line="$line $(json "$dir/$variant.json" peakRSS) $estimated"
+        for f in $FORMATS; do
+            files="$dir/*.$f"
+            #the nets format also writes a .nodes file
+            [ "$f" = nets ] && files="$files $dir/*.nodes"
+            line="$line $(cat $files 2>/dev/null | wc -c)"
+        done
+        echo "$line" >>"$result"
+        #keep the specs and reports, the netlists can be large
+        for f in $FORMATS; do
+            [ "$f" = json ] || rm -f "$dir"/*.$f
+        done
+        rm -f "$dir"/*.nodes
+    done
+done
+echo "results written to $result" >&2
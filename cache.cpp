@@ -0,0 +1,359 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "cache.h"
+#include "main.h"
+#include "pvtools.h"
+#include <sstream>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+string InstanceCache::optionsText;
+vector<Librarycell *> InstanceCache::cells;
+map<Librarycell *, int> InstanceCache::cellIds;
+
+void InstanceCache::Begin() {
+    ostringstream text;
+    text.precision(17);
+    text << "gnl " << Globals::version << " cache " << version << "\n" << GenerationOptions();
+    //the size of the circuit scales the path lengths of every module
+    text << "circuit " << Globals::circuit->Size() << "\n";
+
+    NumberCells();
+    for (int c = 0; c < int(cells.size()); ++c)
+        text << "cell " << c << ' ' << cells[c]->Name() << ' ' << cells[c]->I() << ' ' << cells[c]->O() << ' '
+             << cells[c]->Sequential() << ' ' << cells[c]->Size() << ' ' << cells[c]->Weight() << ' '
+             << cells[c]->Delay() << "\n";
+    text << "flop " << (Globals::flop ? cellIds[Globals::flop] : -1) << "\n";
+    optionsText = text.str();
+
+    if (mkdir(argRead.cacheDir.c_str(), 0777) && errno != EEXIST)
+        throw ("Cannot create cache directory " + argRead.cacheDir);
+}
+
+//the options that change the netlist of a module
+string InstanceCache::GenerationOptions() {
+    ostringstream text;
+    text.precision(17);
+    text << argRead.allowLongPaths << ' ' << argRead.allowLoops << ' ' << argRead.minimumInputs << ' '
+         << argRead.minimumOutputs << ' ' << argRead.twoPointNets << ' ' << argRead.minSeqBlocks << ' '
+         << argRead.flopCutOff << ' ' << argRead.correctionThreshold << ' ' << argRead.localConnectionCutOff << ' '
+         << argRead.correctionBucketFactor << ' ' << argRead.noLocalConnections << ' '
+         << argRead.combineAccordingToSize << ' ' << argRead.areaAsWeight << ' ' << argRead.meanGCorrectionFactor
+         << ' ' << argRead.minPathLength << ' ' << argRead.flopInsertProbability << ' ' << argRead.maxPathLength
+         << ' ' << argRead.pathLengthCutOff << ' ' << argRead.minSigmaTFactor << ' ' << argRead.statisticsOnly
+         << ' ' << argRead.meanTCorrectionFactor << ' ' << argRead.dontInsertFlops << "\ndsd";
+    for (list<float>::iterator di = argRead.delayShapeDistribution.begin();
+         di != argRead.delayShapeDistribution.end(); ++di)
+        text << ' ' << *di;
+    text << "\n";
+    return text.str();
+}
+
+//the library cells, numbered in the order of the libraries
+void InstanceCache::NumberCells() {
+    cells.clear();
+    cellIds.clear();
+    for (map<string, Library>::iterator li = Globals::libraries.begin(); li != Globals::libraries.end(); ++li)
+        for (list<Cell *>::iterator ci = li->second.cells.begin(); ci != li->second.cells.end(); ++ci) {
+            Librarycell *libcell = dynamic_cast<Librarycell *>(*ci);
+            if (!libcell)
+                continue;
+            cellIds[libcell] = cells.size();
+            cells.push_back(libcell);
+        }
+}
+
+string InstanceCache::Key(ModuleType *modType, unsigned int seed, const vector<string> &childKeys) {
+    ostringstream text;
+    text.precision(17);
+    text << optionsText << "type " << modType->Name() << ' ' << modType->I() << ' ' << modType->O() << ' '
+         << modType->Size() << ' ' << modType->NumBlocks() << "\n";
+    list<int>::iterator di = modType->distribution.begin();
+    for (list<string>::iterator li = modType->libraries.begin(); li != modType->libraries.end(); ++li) {
+        text << "library " << *li;
+        list<Cell *> &libraryCells = Globals::libraries[*li].cells;
+        for (list<Cell *>::iterator ci = libraryCells.begin(); ci != libraryCells.end(); ++ci, ++di) {
+            Librarycell *libcell = dynamic_cast<Librarycell *>(*ci);
+            text << ' ' << (libcell ? stringPrintf("%d", cellIds[libcell]) : (*ci)->Name()) << ':' << *di;
+        }
+        text << "\n";
+    }
+    for (map<int, ModuleType::Region>::iterator ri = modType->regions.begin(); ri != modType->regions.end(); ++ri) {
+        ModuleType::Region &region = ri->second;
+        text << "region " << ri->first << ' ' << region.meanT << ' ' << region.sigmaT << ' ' << region.p << ' '
+             << region.q << ' ' << region.meanG << ' ' << region.sigmaG;
+        if (ri->first > 1)
+            text << ' ' << region.g_factor;
+        text << "\n";
+    }
+    text << "seed " << seed << "\ninstances";
+    for (vector<string>::const_iterator ki = childKeys.begin(); ki != childKeys.end(); ++ki)
+        text << ' ' << *ki;
+    return Hash(text.str());
+}
+
+//two 64-bit FNV-1a hashes with different offsets
+string InstanceCache::Hash(const string &text) {
+    unsigned long long a = 14695981039346656037ULL, b = 0x84222325cbf29ce4ULL;
+    for (string::const_iterator ti = text.begin(); ti != text.end(); ++ti) {
+        a = (a ^ (unsigned char) *ti) * 1099511628211ULL;
+        b = (b ^ (unsigned char) *ti) * 1099511628211ULL;
+    }
+    return stringPrintf("%016llx%016llx", a, b);
+}
+
+bool InstanceCache::Exists(const string &key) {
+    struct stat status;
+    return !stat(FileName(key).c_str(), &status);
+}
+
+Module *InstanceCache::Load(const string &key, map<string, list<string> > &hierarchy) {
+    string fileName = FileName(key);
+    ifstream in(fileName.c_str(), ios::binary);
+    if (!in)
+        throw ("Cannot open " + fileName + " for reading");
+    try {
+        return Read(in, hierarchy);
+    }
+    catch (const char *msg) {
+        throw (fileName + ": " + msg + " (remove it to generate the instance again)");
+    }
+}
+
+void InstanceCache::Store(const string &key, Module *module, const map<string, list<string> > &hierarchy) {
+    //written under a name of its own and renamed, so no other run sees a partial file
+    ostringstream tempName;
+    tempName << FileName(key) << '.' << getpid() << '.' << this_thread::get_id();
+    ofstream out(tempName.str().c_str(), ios::binary);
+    if (!out)
+        throw ("Cannot open " + tempName.str() + " for writing");
+    Put(out, magic);
+    Put(out, version);
+    WriteModule(out, module);
+    Put(out, int(hierarchy.size()));
+    for (map<string, list<string> >::const_iterator hi = hierarchy.begin(); hi != hierarchy.end(); ++hi) {
+        PutString(out, hi->first);
+        Put(out, int(hi->second.size()));
+        for (list<string>::const_iterator si = hi->second.begin(); si != hi->second.end(); ++si)
+            PutString(out, *si);
+    }
+    out.close();
+    if (!out || rename(tempName.str().c_str(), FileName(key).c_str()))
+        throw ("Cannot write " + FileName(key));
+}
+
+void InstanceCache::WriteModule(ostream &out, Module *module) {
+    Put(out, module->area);
+    Put(out, module->weight);
+    Put(out, module->numBlocks);
+    Put(out, module->numInputs);
+    Put(out, module->numOutputs);
+    Put(out, module->number);
+
+    map<Module::Block *, int> blockIds;
+    Put(out, int(module->blocks.size()));
+    for (list<Module::Block *>::iterator bi = module->blocks.begin(); bi != module->blocks.end(); ++bi) {
+        int id = blockIds.size();
+        blockIds[*bi] = id;
+        Put(out, cellIds[(*bi)->cell]);
+        Put(out, (*bi)->moduleNumber);
+        Put(out, (*bi)->order);
+    }
+
+    //the pins of the blocks follow from the sources and sinks of the nets. The nets that feed an
+    //inserted flop are in none of the lists of the module (see OutputNet::AddFlop)
+    map<Module::OutputNet *, int> netIds;
+    list<Module::OutputNet *> outputNets(module->outputs);
+    outputNets.insert(outputNets.end(), module->internalNets.begin(), module->internalNets.end());
+    for (list<Module::OutputNet *>::iterator ni = outputNets.begin(); ni != outputNets.end(); ++ni)
+        netIds[*ni] = 0;
+    int numUnlisted = 0;
+    for (list<Module::Block *>::iterator bi = module->blocks.begin(); bi != module->blocks.end(); ++bi)
+        for (vector<Module::OutputNet *>::iterator ni = (*bi)->outputs.begin(); ni != (*bi)->outputs.end(); ++ni)
+            if (netIds.insert(make_pair(*ni, 0)).second) {
+                outputNets.push_back(*ni);
+                ++numUnlisted;
+            }
+    Put(out, int(module->outputs.size()));
+    Put(out, int(module->internalNets.size()));
+    Put(out, numUnlisted);
+    int id = 0;
+    for (list<Module::OutputNet *>::iterator ni = outputNets.begin(); ni != outputNets.end(); ++ni) {
+        netIds[*ni] = id++;
+        Put(out, blockIds[(*ni)->source.first]);
+        Put(out, (*ni)->source.second);
+        Put(out, (*ni)->maxLength);
+        PutSinks(out, *ni, blockIds);
+    }
+    Put(out, int(module->inputs.size()));
+    for (list<Module::InputNet *>::iterator ni = module->inputs.begin(); ni != module->inputs.end(); ++ni) {
+        Put(out, (*ni)->requiredMinLength);
+        Put(out, (*ni)->allowedMaxLength);
+        PutSinks(out, *ni, blockIds);
+        Put(out, int((*ni)->controllableOutputs.size()));
+        for (DelayVector<Module::OutputNet>::const_iterator ci = (*ni)->controllableOutputs.begin();
+             ci != (*ni)->controllableOutputs.end(); ++ci) {
+            map<Module::OutputNet *, int>::iterator ii = netIds.find(ci->first);
+            if (ii == netIds.end())
+                throw ("Internal error: controllable output not in the module");
+            Put(out, ii->second);
+            Put(out, ci->second);
+        }
+    }
+}
+
+Module *InstanceCache::Read(istream &in, map<string, list<string> > &hierarchy) {
+    if (Get<unsigned int>(in) != magic || Get<unsigned int>(in) != version)
+        throw ("not a cache file of this version");
+    Module *module = ReadModule(in);
+    try {
+        for (int entries = Get<int>(in); entries > 0; --entries) {
+            list<string> &children = hierarchy[GetString(in)];
+            for (int size = Get<int>(in); size > 0; --size)
+                children.push_back(GetString(in));
+        }
+    }
+    catch (...) {
+        delete module;
+        throw;
+    }
+    return module;
+}
+
+Module *InstanceCache::ReadModule(istream &in) {
+    Module *module = new Module;
+    try {
+        module->area = Get<int>(in);
+        module->weight = Get<int>(in);
+        module->numBlocks = Get<int>(in);
+        module->numInputs = Get<int>(in);
+        module->numOutputs = Get<int>(in);
+        module->number = Get<int>(in);
+
+        vector<Module::Block *> blocks(Get<int>(in));
+        for (vector<Module::Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi) {
+            int cell = Get<int>(in);
+            if (cell < 0 || cell >= int(cells.size()))
+                throw ("unknown library cell");
+            *bi = new Module::Block(cells[cell]);
+            module->blocks.push_back(*bi);
+            (*bi)->moduleNumber = Get<int>(in);
+            (*bi)->order = Get<int>(in);
+            (*bi)->mark = 0;
+        }
+
+        int numOutputs = Get<int>(in), numInternal = Get<int>(in), numUnlisted = Get<int>(in);
+        if (numOutputs < 0 || numInternal < 0 || numUnlisted < 0)
+            throw ("wrong number of nets");
+        vector<Module::OutputNet *> outputNets;
+        for (int n = 0; n < numOutputs + numInternal + numUnlisted; ++n) {
+            Module::OutputNet *net = new Module::OutputNet(0);
+            if (n < numOutputs)
+                module->outputs.push_back(net);
+            else if (n < numOutputs + numInternal)
+                module->internalNets.push_back(net);
+            outputNets.push_back(net);
+            int block = Get<int>(in);
+            unsigned int pin = Get<unsigned int>(in);
+            if (block < 0 || block >= int(blocks.size()) || pin >= blocks[block]->outputs.size())
+                throw ("wrong net source");
+            net->source = Module::Terminal(blocks[block], pin);
+            blocks[block]->outputs[pin] = net;
+            net->maxLength = Get<double>(in);
+            GetSinks(in, net, blocks);
+        }
+        int numInputs = Get<int>(in);
+        for (int n = 0; n < numInputs; ++n) {
+            double minLength = Get<double>(in), maxLength = Get<double>(in);
+            Module::InputNet *net = new Module::InputNet(minLength, maxLength);
+            module->inputs.push_back(net);
+            GetSinks(in, net, blocks);
+            int size = Get<int>(in);
+            for (int i = 0; i < size; ++i) {
+                int id = Get<int>(in);
+                if (id < 0 || id >= int(outputNets.size()))
+                    throw ("wrong controllable output");
+                net->controllableOutputs.Insert(outputNets[id], Get<double>(in));
+            }
+            Statistics::ControllableOutputs(size);
+        }
+        for (vector<Module::Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
+            if (find((*bi)->inputs.begin(), (*bi)->inputs.end(), (Module::Net *) 0) != (*bi)->inputs.end() ||
+                find((*bi)->outputs.begin(), (*bi)->outputs.end(), (Module::OutputNet *) 0) != (*bi)->outputs.end())
+                throw ("unconnected pin");
+    }
+    catch (...) {
+        delete module;
+        throw;
+    }
+    return module;
+}
+
+void InstanceCache::PutString(ostream &out, const string &s) {
+    Put(out, int(s.size()));
+    out.write(s.data(), s.size());
+}
+
+string InstanceCache::GetString(istream &in) {
+    int size = Get<int>(in);
+    if (size < 0 || size > 4096)
+        throw ("wrong string length");
+    string s(size, ' ');
+    if (!in.read(&s[0], size))
+        throw ("truncated file");
+    return s;
+}
+
+void InstanceCache::PutSinks(ostream &out, Module::Net *net, map<Module::Block *, int> &blockIds) {
+    Put(out, int(net->sinks.size()));
+    for (list<Module::Terminal>::iterator ti = net->sinks.begin(); ti != net->sinks.end(); ++ti) {
+        Put(out, blockIds[ti->first]);
+        Put(out, ti->second);
+    }
+}
+
+void InstanceCache::GetSinks(istream &in, Module::Net *net, vector<Module::Block *> &blocks) {
+    for (int size = Get<int>(in); size > 0; --size) {
+        int block = Get<int>(in);
+        unsigned int pin = Get<unsigned int>(in);
+        if (block < 0 || block >= int(blocks.size()) || pin >= blocks[block]->inputs.size() ||
+            blocks[block]->inputs[pin])
+            throw ("wrong net sink");
+        net->AddSink(Module::Terminal(blocks[block], pin));
+        blocks[block]->inputs[pin] = net;
+    }
+}
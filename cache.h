@@ -0,0 +1,113 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Cache
+#define _H_Cache
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <iostream>
+#include "modules.h"
+
+using namespace std;
+
+//On-disk cache of pre-generated macrocell instances (-cache <dir>, see MacrocellScheduler). Every
+//file holds one instance: its netlist in a compact binary form and the hierarchy of instances below
+//it. It is named after a 128-bit hash of all the instance depends on: the definition of its module
+//type and library cells, the generation options, the size of the circuit, the seed of the instance
+//and the keys of the instances it contains. A later run with the same inputs loads the file instead
+//of generating the instance (and the instances below it).
+class InstanceCache {
+public:
+    static bool On() { return !argRead.cacheDir.empty(); }
+
+    //hashes the options and numbers the library cells; call it once on the main thread before Key
+    static void Begin();
+
+    //the key of an instance of modType generated with seed, containing the instances with childKeys
+    static string Key(ModuleType *modType, unsigned int seed, const vector<string> &childKeys);
+
+    static bool Exists(const string &key);
+
+    //the cached instance and the hierarchy below it; throws if the file is corrupt
+    static Module *Load(const string &key, map<string, list<string> > &hierarchy);
+
+    static void Store(const string &key, Module *module, const map<string, list<string> > &hierarchy);
+
+    //the values of the options that change the netlist of a module, as text
+    static string GenerationOptions();
+
+    //numbers the library cells, which the netlists refer to; Begin calls it
+    static void NumberCells();
+
+    //a netlist in the binary form of the cache files (also used by Checkpoint)
+    static void WriteModule(ostream &out, Module *module);
+
+    static Module *ReadModule(istream &in);
+
+    //a 128-bit hash of text, in hexadecimal
+    static string Hash(const string &text);
+
+    template<class T>
+    static void Put(ostream &out, T value) { out.write((const char *) &value, sizeof(T)); }
+
+    template<class T>
+    static T Get(istream &in) {
+        T value;
+        if (!in.read((char *) &value, sizeof(T)))
+            throw ("truncated file");
+        return value;
+    }
+
+    static void PutString(ostream &out, const string &s);
+
+    static string GetString(istream &in);
+
+private:
+    static string FileName(const string &key) { return argRead.cacheDir + "/" + key + ".gnli"; }
+
+    static void PutSinks(ostream &out, Module::Net *net, map<Module::Block *, int> &blockIds);
+
+    static void GetSinks(istream &in, Module::Net *net, vector<Module::Block *> &blocks);
+
+    static Module *Read(istream &in, map<string, list<string> > &hierarchy);
+
+    static string optionsText;
+    static vector<Librarycell *> cells;
+    static map<Librarycell *, int> cellIds;
+
+    static const unsigned int magic = 0x494c4e47;   //"GNLI"
+    static const unsigned int version = 1;
+};
+
+#endif //{_H_Cache}
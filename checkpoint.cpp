@@ -0,0 +1,278 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "checkpoint.h"
+#include "cache.h"
+#include "scheduler.h"
+#include "statistics.h"
+#include "topology.h"
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+string Checkpoint::runKey;
+bool Checkpoint::resume;
+chrono::steady_clock::time_point Checkpoint::due;
+int Checkpoint::lastNode;
+int Checkpoint::treeRecords;
+vector<int> Checkpoint::written;
+
+void Checkpoint::Begin() {
+    if (MacrocellScheduler::On())
+        throw ("-checkpoint cannot be combined with -pmi or -cache");
+    list<string> &formats = argRead.outputFormats;
+    if (!argRead.traceFile.empty() || find(formats.begin(), formats.end(), "tree") != formats.end() ||
+        find(formats.begin(), formats.end(), "ptree") != formats.end())
+        throw ("-checkpoint cannot be combined with the tree and ptree formats or the trace");
+
+    //a run is identified by the gnl file, the seed and the options that change the netlist
+    ostringstream text;
+    ifstream gnl(argRead.gnlFile.c_str());
+    text << gnl.rdbuf() << "\nseed " << argRead.seed << "\n" << InstanceCache::GenerationOptions();
+    runKey = InstanceCache::Hash(text.str());
+    InstanceCache::NumberCells();
+    written.clear();
+    treeRecords = 0;
+    due = chrono::steady_clock::now() + chrono::seconds(argRead.checkpointInterval);
+
+    if (mkdir(argRead.checkpointDir.c_str(), 0777) && errno != EEXIST)
+        throw ("Cannot create checkpoint directory " + argRead.checkpointDir);
+    resume = 0;
+    if (argRead.resume) {
+        struct stat status;
+        resume = !stat(FileName("state").c_str(), &status);
+        if (!resume)
+            lout << "No checkpoint in " << argRead.checkpointDir << ": generating from the start.\n";
+    }
+    if (!resume)
+        Remove();
+}
+
+int Checkpoint::Resume(ModuleType *modType, vector<Module *> &built) {
+    ModuleType::PartitionTree &tree = modType->partitionTree;
+    lastNode = tree.Size() - 1;
+    if (!resume)
+        return lastNode;
+
+    string fileName = FileName("state");
+    ifstream in(fileName.c_str(), ios::binary);
+    try {
+        if (InstanceCache::Get<unsigned int>(in) != magic || InstanceCache::Get<unsigned int>(in) != version)
+            throw ("not a checkpoint of this version");
+        if (InstanceCache::GetString(in) != runKey)
+            throw ("written by a run with another gnl file or other options");
+        int node = InstanceCache::Get<int>(in);
+        if (node < 0 || node >= tree.Size())
+            throw ("wrong node");
+        treeRecords = InstanceCache::Get<int>(in);
+        randomRestoreState(InstanceCache::GetString(in));
+        Globals::moduleCounter = InstanceCache::Get<int>(in);
+        Globals::progress = InstanceCache::Get<int>(in);
+        TopologicalOrder::next = InstanceCache::Get<int>(in);
+        for (int c = 0; c < Statistics::numCounters; ++c)
+            Statistics::counters[c] = InstanceCache::Get<long>(in);
+
+        modType->distributionBuckets.clear();
+        for (int size = InstanceCache::Get<int>(in); size > 0; --size) {
+            ModuleType::DistribBucket &bucket = modType->distributionBuckets[InstanceCache::Get<int>(in)];
+            bucket.sumT = InstanceCache::Get<unsigned long>(in);
+            bucket.sumG = InstanceCache::Get<double>(in);
+            bucket.number = InstanceCache::Get<unsigned int>(in);
+            bucket.newMeanT = InstanceCache::Get<double>(in);
+            bucket.newMeanG = InstanceCache::Get<double>(in);
+        }
+        map<string, ModuleType *> types;
+        for (map<string, Library>::iterator li = Globals::libraries.begin(); li != Globals::libraries.end(); ++li)
+            for (list<Cell *>::iterator ci = li->second.cells.begin(); ci != li->second.cells.end(); ++ci)
+                if (ModuleType *macroType = dynamic_cast<ModuleType *>(*ci))
+                    types[macroType->Name()] = macroType;
+        for (int size = InstanceCache::Get<int>(in); size > 0; --size) {
+            map<string, ModuleType *>::iterator ti = types.find(InstanceCache::GetString(in));
+            if (ti == types.end())
+                throw ("unknown module type");
+            ti->second->number = InstanceCache::Get<int>(in);
+        }
+        Globals::hierarchy.clear();
+        for (int size = InstanceCache::Get<int>(in); size > 0; --size) {
+            list<string> &children = Globals::hierarchy[InstanceCache::GetString(in)];
+            for (int n = InstanceCache::Get<int>(in); n > 0; --n)
+                children.push_back(InstanceCache::GetString(in));
+        }
+        for (int size = InstanceCache::Get<int>(in); size > 0; --size)
+            written.push_back(InstanceCache::Get<int>(in));
+
+        //the tree file can hold the records of a checkpoint that was not finished
+        string treeName = FileName("tree");
+        ifstream treeIn(treeName.c_str(), ios::binary);
+        for (int r = 0; r < treeRecords; ++r) {
+            int n = InstanceCache::Get<int>(treeIn);
+            if (n <= node || n >= tree.Size())
+                throw ("wrong node in the tree file");
+            tree.area[n] = InstanceCache::Get<int>(treeIn);
+            tree.numBlocks[n] = InstanceCache::Get<int>(treeIn);
+            tree.numInputs[n] = InstanceCache::Get<int>(treeIn);
+            tree.numOutputs[n] = InstanceCache::Get<int>(treeIn);
+        }
+        if (truncate(treeName.c_str(), long(treeRecords) * 5 * sizeof(int)))
+            throw ("cannot truncate the tree file");
+
+        for (vector<int>::iterator wi = written.begin(); wi != written.end(); ++wi) {
+            ifstream moduleIn(ModuleFile(*wi).c_str(), ios::binary);
+            if (!moduleIn)
+                throw ("module file missing");
+            built.push_back(InstanceCache::ReadModule(moduleIn));
+            if (built.back()->number != *wi)
+                throw ("wrong module file");
+        }
+        lastNode = node;
+    }
+    catch (const char *msg) {
+        for (vector<Module *>::iterator mi = built.begin(); mi != built.end(); ++mi)
+            delete *mi;
+        throw (fileName + ": " + msg);
+    }
+    lout << "Resuming the generation of " << modType->Name() << " from the checkpoint in "
+         << argRead.checkpointDir << " (" << (tree.Size() - 1 - lastNode) << " of " << tree.Size()
+         << " tree nodes built).\n";
+    return lastNode;
+}
+
+void Checkpoint::Write(ModuleType *modType, int node, const vector<Module *> &built) {
+    ModuleType::PartitionTree &tree = modType->partitionTree;
+    //the modules that are new on the stack; the other ones are in the last checkpoint
+    vector<int> numbers;
+    for (vector<Module *>::const_iterator mi = built.begin(); mi != built.end(); ++mi) {
+        numbers.push_back((*mi)->number);
+        if (find(written.begin(), written.end(), (*mi)->number) != written.end())
+            continue;
+        ofstream out(ModuleFile((*mi)->number).c_str(), ios::binary);
+        InstanceCache::WriteModule(out, *mi);
+        out.close();
+        if (!out)
+            throw ("Cannot write " + ModuleFile((*mi)->number));
+    }
+
+    //the tree nodes built since the last checkpoint
+    ofstream treeOut(FileName("tree").c_str(), ios::binary | ios::app);
+    for (int n = lastNode; n > node; --n, ++treeRecords) {
+        InstanceCache::Put(treeOut, n);
+        InstanceCache::Put(treeOut, tree.area[n]);
+        InstanceCache::Put(treeOut, tree.numBlocks[n]);
+        InstanceCache::Put(treeOut, tree.numInputs[n]);
+        InstanceCache::Put(treeOut, tree.numOutputs[n]);
+    }
+    treeOut.close();
+    if (!treeOut)
+        throw ("Cannot write " + FileName("tree"));
+
+    string tempName = FileName("state.tmp");
+    ofstream out(tempName.c_str(), ios::binary);
+    InstanceCache::Put(out, magic);
+    InstanceCache::Put(out, version);
+    InstanceCache::PutString(out, runKey);
+    InstanceCache::Put(out, node);
+    InstanceCache::Put(out, treeRecords);
+    InstanceCache::PutString(out, randomSaveState());
+    InstanceCache::Put(out, Globals::moduleCounter);
+    InstanceCache::Put(out, Globals::progress);
+    InstanceCache::Put(out, TopologicalOrder::next);
+    for (int c = 0; c < Statistics::numCounters; ++c)
+        InstanceCache::Put(out, Statistics::counters[c]);
+    InstanceCache::Put(out, int(modType->distributionBuckets.size()));
+    for (map<int, ModuleType::DistribBucket>::iterator bi = modType->distributionBuckets.begin();
+         bi != modType->distributionBuckets.end(); ++bi) {
+        InstanceCache::Put(out, bi->first);
+        InstanceCache::Put(out, bi->second.sumT);
+        InstanceCache::Put(out, bi->second.sumG);
+        InstanceCache::Put(out, bi->second.number);
+        InstanceCache::Put(out, bi->second.newMeanT);
+        InstanceCache::Put(out, bi->second.newMeanG);
+    }
+    vector<ModuleType *> types;
+    for (map<string, Library>::iterator li = Globals::libraries.begin(); li != Globals::libraries.end(); ++li)
+        for (list<Cell *>::iterator ci = li->second.cells.begin(); ci != li->second.cells.end(); ++ci)
+            if (ModuleType *macroType = dynamic_cast<ModuleType *>(*ci))
+                types.push_back(macroType);
+    InstanceCache::Put(out, int(types.size()));
+    for (vector<ModuleType *>::iterator ti = types.begin(); ti != types.end(); ++ti) {
+        InstanceCache::PutString(out, (*ti)->Name());
+        InstanceCache::Put(out, (*ti)->number);
+    }
+    InstanceCache::Put(out, int(Globals::hierarchy.size()));
+    for (map<string, list<string> >::iterator hi = Globals::hierarchy.begin(); hi != Globals::hierarchy.end(); ++hi) {
+        InstanceCache::PutString(out, hi->first);
+        InstanceCache::Put(out, int(hi->second.size()));
+        for (list<string>::iterator si = hi->second.begin(); si != hi->second.end(); ++si)
+            InstanceCache::PutString(out, *si);
+    }
+    InstanceCache::Put(out, int(numbers.size()));
+    for (vector<int>::iterator ni = numbers.begin(); ni != numbers.end(); ++ni)
+        InstanceCache::Put(out, *ni);
+    out.close();
+    if (!out || rename(tempName.c_str(), FileName("state").c_str()))
+        throw ("Cannot write " + FileName("state"));
+
+    //the modules that were combined since the last checkpoint
+    for (vector<int>::iterator wi = written.begin(); wi != written.end(); ++wi)
+        if (find(numbers.begin(), numbers.end(), *wi) == numbers.end())
+            remove(ModuleFile(*wi).c_str());
+    written.swap(numbers);
+    lastNode = node;
+    due = chrono::steady_clock::now() + chrono::seconds(argRead.checkpointInterval);
+}
+
+void Checkpoint::End() {
+    if (On())
+        Remove();
+}
+
+//removes the files of a checkpoint from the directory
+void Checkpoint::Remove() {
+    remove(FileName("state").c_str());
+    remove(FileName("state.tmp").c_str());
+    remove(FileName("tree").c_str());
+    DIR *dir = opendir(argRead.checkpointDir.c_str());
+    if (!dir)
+        return;
+    while (struct dirent *entry = readdir(dir)) {
+        string name = entry->d_name;
+        if (name.size() > 6 && name[0] == 'm' && name.compare(name.size() - 5, 5, ".gnlm") == 0)
+            remove(FileName(name).c_str());
+    }
+    closedir(dir);
+    written.clear();
+    treeRecords = 0;
+}
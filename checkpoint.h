@@ -0,0 +1,92 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Checkpoint
+#define _H_Checkpoint
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include "main.h"
+#include "pvtools.h"
+
+using namespace std;
+
+//Checkpoints of the generation of the circuit (-checkpoint <dir>), so that a run that is killed can
+//be continued with -resume. The partition tree is built again from the seed when a run resumes, so a
+//checkpoint only holds what building the modules changed: the netlists of the completed subtrees on
+//the stack of BuildModule (a file per module, written once and removed once it is combined), the
+//sizes and pin counts of the tree nodes built so far (appended to one file) and a small state file
+//with the next node, the random generator, the correction buckets, the instance numbers, the
+//hierarchy and the counters. The state file is replaced by a rename, so a run that is killed while
+//writing a checkpoint resumes from the previous one, and the output is the same as without a break.
+class Checkpoint {
+public:
+    static bool On() { return !argRead.checkpointDir.empty(); }
+
+    //checks the options and the checkpoint to resume from; call it before the circuit is generated
+    static void Begin();
+
+    //restores the last checkpoint of the circuit into modType and built; the next node to build, or
+    //the last node of the tree if the generation does not resume
+    static int Resume(ModuleType *modType, vector<Module *> &built);
+
+    //whether a checkpoint is due before the next node of modType is built
+    static bool Due(ModuleType *modType) {
+        return On() && modType == Globals::circuit && chrono::steady_clock::now() >= due;
+    }
+
+    //writes a checkpoint; node is the next node to build and built the stack of BuildModule
+    static void Write(ModuleType *modType, int node, const vector<Module *> &built);
+
+    //removes the checkpoint once the circuit is written
+    static void End();
+
+private:
+    static string FileName(const string &name) { return argRead.checkpointDir + "/" + name; }
+
+    static string ModuleFile(int number) { return FileName(stringPrintf("m%d.gnlm", number)); }
+
+    static void Remove();
+
+    static string runKey;
+    static bool resume;
+    static chrono::steady_clock::time_point due;
+    static int lastNode;                //the next node at the last checkpoint
+    static int treeRecords;             //in the tree file at the last checkpoint
+    static vector<int> written;         //the numbers of the modules in the last checkpoint
+
+    static const unsigned int magic = 0x434c4e47;   //"GNLC"
+    static const unsigned int version = 1;
+};
+
+#endif //{_H_Checkpoint}
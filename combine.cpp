@@ -33,8 +33,14 @@
 #include "argread.h"
 #include "pvtools.h"
 #include "debug.h"
+#include "trace.h"
+#include "progress.h"
+#include "statistics.h"
+#include "topology.h"
+#include "timing.h"
 
 Module::~Module() {
+    PhaseTimer timer(Statistics::deleteModule);
     for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
         delete *bi;
     for (list<OutputNet *>::iterator ni = internalNets.begin(); ni != internalNets.end(); ++ni)
@@ -43,6 +49,8 @@ Module::~Module() {
         delete *ni;
     for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
         delete *ni;
+    for (list<InputNet *>::iterator ni = forwardingNets.begin(); ni != forwardingNets.end(); ++ni)
+        delete *ni;
 }
 
 Module::Module(Librarycell *cell) : numBlocks(1) {
@@ -50,8 +58,17 @@ Module::Module(Librarycell *cell) : numBlocks(1) {
     weight = cell->Weight();
     numInputs = cell->I();
     numOutputs = cell->O();
+    if (!argRead.statisticsOnly)
+        CreateBlock(cell);
+    Progress::BlockCreated();
+
+    StoreTreeData(0, 0);
+}
+
+void Module::CreateBlock(Librarycell *cell) {
     Block *block = new Block(cell);
     block->moduleNumber = number;
+    TopologicalOrder::Add(block);
     blocks.push_back(block);
     for (int n = 0; n < numInputs; ++n) {
         double maxDelay = Globals::delays.Sample(), minDelay = min(double(argRead.minPathLength), maxDelay / 2);
@@ -61,7 +78,7 @@ Module::Module(Librarycell *cell) : numBlocks(1) {
         }
         InputNet *net = new InputNet(minDelay, maxDelay);
         inputs.push_back(net);
-        net->sinks.push_back(Terminal(block, n));
+        net->AddSink(Terminal(block, n));
         block->inputs[n] = net;
     }
     for (int n = 0; n < numOutputs; ++n) {
@@ -71,17 +88,11 @@ Module::Module(Librarycell *cell) : numBlocks(1) {
         block->outputs[n] = net;
     }
 
-    if (!argRead.allowLoops && !cell->Sequential()) {
-        for (list<InputNet *>::iterator ii = inputs.begin(); ii != inputs.end(); ++ii)
-            for (list<OutputNet *>::iterator oi = outputs.begin(); oi != outputs.end(); ++oi)
-                (*ii)->controllableOutputs[*oi] = cell->Delay();
-    }
-
-    number = ++Globals::moduleCounter;
-    Globals::treeData.push_back(Globals::PtreeNode(number, -1, -1, weight, numBlocks, numInputs, numOutputs));
+    PathTiming::AddBlock(this, cell);
 }
 
 Module::Module(Module *modA, Module *modB, ModuleType *modType) {
+    Statistics::Count(Statistics::combines);
     //Get number of inputs and outputs of modA, modB and target module
     int ia = modA->numInputs;
     int ib = modB->numInputs;
@@ -134,7 +145,7 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
     if (se + si == 0 && !argRead.twoPointNets)
         se = 1;
 
-    if (argRead.debugBits & debug::combine) {
+    if (debug::On(debug::combine)) {
         dout << "Combining modules -- ";
         dout << "B: " << modA->numBlocks << " " << modB->numBlocks << " " << numBlocks << ", ";
         dout << "T: " << (ia + oa) << " " << (ib + ob) << " " << (ic + oc) << ", ";
@@ -143,6 +154,33 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
         dout << "se=" << se << ", si=" << si << endl;
     }
 
+    if (argRead.statisticsOnly) {
+        CountConnections(modA, modB, modType, se, si);
+        modType->PutIO(area, numInputs, numOutputs);
+        if (debug::On(debug::combine))
+            dout << "Result: I=" << numInputs << ", O=" << numOutputs << endl << endl;
+        StoreTreeData(modA, modB);
+        return;
+    }
+
+    bool tracing = Trace::On();
+    TraceRecord record(TraceRecord::combineRecord, Globals::moduleCounter + 1);
+    if (tracing) {
+        record.combine.moduleA = modA->number;
+        record.combine.moduleB = modB->number;
+        record.combine.blocksA = modA->numBlocks;
+        record.combine.blocksB = modB->numBlocks;
+        record.combine.ia = ia;
+        record.combine.oa = oa;
+        record.combine.ib = ib;
+        record.combine.ob = ob;
+        record.combine.targetI = par_ic;
+        record.combine.targetO = par_oc;
+        record.combine.se = se;
+        record.combine.si = si;
+    }
+    int joinAttempts = 0;
+
     //make connections by combining nets
     //  current schemes:
     //    * make external connections from A to B and from B to A in a random order
@@ -154,13 +192,19 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
     list<InputNet *>::iterator ibi = modB->inputs.begin();
     list<OutputNet *>::iterator oai = modA->outputs.begin();
     list<OutputNet *>::iterator obi = modB->outputs.begin();
+    //the area only grows by inserting flops, which needs it above the cut-off already
+    bool flops = !argRead.dontInsertFlops && Globals::flop &&
+                 log(double(Size())) / log(double(modType->Size())) * 100 > argRead.flopCutOff;
 
-    if (argRead.debugBits & debug::combine)
+    if (debug::On(debug::combine))
         dout << "   phase 1: ";
 
     //loop over outputs of A and then over inputs of B, also
     //loop over outputs of B and then over inputs of A. Select a
-    //connection at random and make that connection if allowed
+    //connection at random and make that connection if allowed.
+    //The input lists are shuffled at the end of every combination, so this scan already draws the
+    //inputs for an output at random without replacement. Most candidates are rejected; the ones
+    //that Join would turn down without side effects are skipped without calling it
     bool aToB, bToA, firstConnection = 1;
     while (external < se + si) {
         list<OutputNet *>::iterator toSplice;
@@ -171,7 +215,9 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
             break;
         if (!bToA || (aToB && (randomNumber(2) || firstConnection))) {
             //make AtoB connection if allowed, else move on
-            if ((*oai)->Join(*ibi, modA, modB, this, delayScaleFactor, modType)) {
+            ++joinAttempts;
+            if (OutputNet::Connectable((*oai)->Check(*ibi, delayScaleFactor), flops) &&
+                (*oai)->Join(*ibi, modA, modB, this, delayScaleFactor, modType)) {
                 toSplice = oai++;
                 outputs.splice(outputs.begin(), modA->outputs, toSplice);
                 modB->inputs.erase(ibi);
@@ -184,7 +230,9 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
             }
         } else {
             //make BtoA connection if allowed, else move on
-            if ((*obi)->Join(*iai, modB, modA, this, delayScaleFactor, modType)) {
+            ++joinAttempts;
+            if (OutputNet::Connectable((*obi)->Check(*iai, delayScaleFactor), flops) &&
+                (*obi)->Join(*iai, modB, modA, this, delayScaleFactor, modType)) {
                 toSplice = obi++;
                 outputs.splice(outputs.begin(), modB->outputs, toSplice);
                 modA->inputs.erase(iai);
@@ -199,7 +247,12 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
         firstConnection = 0;
     }
 
-    if (argRead.debugBits & debug::combine) {
+    if (tracing) {
+        record.combine.aToB = externalAtoB;
+        record.combine.bToA = external - externalAtoB;
+    }
+
+    if (debug::On(debug::combine)) {
         dout << "A to B: " << externalAtoB << endl;
         dout << "            B to A: " << (external - externalAtoB) << ", total: " << external << endl;
         dout << "   phase 2: converting to internal nets: ";
@@ -219,7 +272,7 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
     se -= external;
     internalNets.splice(internalNets.end(), outputs, outputs.begin(), li);
 
-    if (argRead.debugBits & debug::combine) {
+    if (debug::On(debug::combine)) {
         dout << internal << ", se=" << se << ", si=" << si << endl;
         dout << "   phase 3: a + b: ";
     }
@@ -227,7 +280,7 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
     //loop over inputs of ModuleA and inputs of Module B and combine
     int inputCombinations = 0;
     while (se > 0 && !modA->inputs.empty() && !modB->inputs.empty()) {
-        modA->inputs.front()->Join(modB->inputs.front());
+        modA->inputs.front()->Join(modB->inputs.front(), this);
         inputs.splice(inputs.begin(), modA->inputs, modA->inputs.begin());
         modB->inputs.pop_front();
         --se;
@@ -235,7 +288,12 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
         ++inputCombinations;
     }
 
-    if (argRead.debugBits & debug::combine)
+    if (tracing) {
+        record.combine.internal = internal;
+        record.combine.inputCombinations = inputCombinations;
+    }
+
+    if (debug::On(debug::combine))
         dout << inputCombinations << ", se=" << se << endl;
 
     //Move remaining blocks and nets
@@ -254,7 +312,7 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
         list<InputNet *>::iterator ii = inputs.begin();
         list<OutputNet *>::iterator oi = outputs.begin();
 
-        if (argRead.debugBits & debug::combine) {
+        if (debug::On(debug::combine)) {
             dout << "   local connections:\n";
             dout << "   phase 4: output connections: ";
         }
@@ -263,7 +321,9 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
             list<OutputNet *>::iterator toSplice;
 
             //make output connection if allowed, else move on
-            if ((*oi)->Join(*ii, this, 0, this, delayScaleFactor, modType)) {
+            ++joinAttempts;
+            if (OutputNet::Connectable((*oi)->Check(*ii, delayScaleFactor), flops) &&
+                (*oi)->Join(*ii, this, 0, this, delayScaleFactor, modType)) {
                 toSplice = oi++;
                 newOutputs.splice(newOutputs.begin(), outputs, toSplice);
                 inputs.erase(ii);
@@ -275,7 +335,10 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
             }
         }
 
-        if (argRead.debugBits & debug::combine) {
+        if (tracing)
+            record.combine.localOutputs = external;
+
+        if (debug::On(debug::combine)) {
             dout << external << endl;
             dout << "   phase 5: converting to internal nets: ";
         }
@@ -294,24 +357,42 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
         se -= external;
         internalNets.splice(internalNets.end(), newOutputs, newOutputs.begin(), li);
 
-        if (argRead.debugBits & debug::combine) {
+        if (debug::On(debug::combine)) {
             dout << internal << ", se=" << se << ", si=" << si << endl;
             dout << "   phase 6: internal connections: ";
         }
 
-        //combine inputs
+        //combine inputs: join a random input into another random input. The candidates are
+        //kept in a vector of list positions, so a pair is drawn in constant time and the
+        //joined input is removed by swapping it with the last candidate
         inputCombinations = 0;
-        while (se > 0 && inputs.size() >= 2) {
-            randomizeList(inputs);
-            InputNet *input = inputs.front();
-            inputs.pop_front();
-            inputs.front()->Join(input);
-            --se;
-            ++external;
-            ++inputCombinations;
+        if (se > 0 && inputs.size() >= 2) {
+            static thread_local vector<list<InputNet *>::iterator> candidates;
+            candidates.clear();
+            for (list<InputNet *>::iterator ii = inputs.begin(); ii != inputs.end(); ++ii)
+                candidates.push_back(ii);
+            int size = int(candidates.size());
+            while (se > 0 && size >= 2) {
+                int from = randomNumber(size);
+                int to = randomNumber(size - 1);
+                if (to >= from)
+                    ++to;
+                list<InputNet *>::iterator input = candidates[from];
+                candidates[from] = candidates[--size];
+                (*candidates[to == size ? from : to])->Join(*input, this);
+                inputs.erase(input);
+                --se;
+                ++external;
+                ++inputCombinations;
+            }
         }
 
-        if (argRead.debugBits & debug::combine)
+        if (tracing) {
+            record.combine.localInternal = internal;
+            record.combine.localInputs = inputCombinations;
+        }
+
+        if (debug::On(debug::combine))
             dout << inputCombinations << ", se=" << se << endl;
 
         outputs.splice(outputs.end(), newOutputs);
@@ -322,7 +403,7 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
     //Store final number of inputs and outputs
     modType->PutIO(area, numInputs, numOutputs);
 
-    if (argRead.debugBits & debug::combine) {
+    if (debug::On(debug::combine)) {
         if (numInputs != int(inputs.size()))
             throw ("Internal error: wrong number of inputs after combining");
         if (numOutputs != int(outputs.size()))
@@ -333,109 +414,220 @@ Module::Module(Module *modA, Module *modB, ModuleType *modType) {
     randomizeList(inputs);
     randomizeList(outputs);
 
+    //bound the memory of the forwarding nets; every resolution follows at least blocks/8 joins
+    if (forwardingNets.size() * forwardingRatio > blocks.size())
+        ResolvePins();
+
+    if (tracing) {
+        record.combine.joinAttempts = joinAttempts;
+        record.combine.flops = numBlocks - record.combine.blocksA - record.combine.blocksB;
+        record.combine.resultI = numInputs;
+        record.combine.resultO = numOutputs;
+        Trace::Write(record);
+    }
+
+    StoreTreeData(modA, modB);
+}
+
+void Module::CountConnections(Module *modA, Module *modB, ModuleType *modType, int se, int si) {
+    //same phases as the netlist combination, but on pin counts only: every connection is
+    //assumed to be allowed, so no flops are inserted
+    int ia = modA->numInputs, ib = modB->numInputs, oa = modA->numOutputs, ob = modB->numOutputs;
+
+    //phase 1: external connections from A to B and from B to A in a random order
+    int external = 0;
+    bool aToB, bToA, firstConnection = 1;
+    while (external < se + si) {
+        aToB = (oa > 0 && ib > 0);
+        bToA = (ob > 0 && ia > 0);
+        if (!aToB && !bToA)
+            break;
+        if (!bToA || (aToB && (randomNumber(2) || firstConnection))) {
+            --oa;
+            --ib;
+        } else {
+            --ob;
+            --ia;
+        }
+        ++external;
+        firstConnection = 0;
+    }
+
+    //phase 2: convert to internal nets
+    int internal = min(si, external);
+    si -= internal;
+    external -= internal;
+    se -= external;
+
+    //phase 3: combine inputs of A and B
+    int inputCombinations = max(0, min(se, min(ia, ib)));
+    se -= inputCombinations;
+    external += inputCombinations;
+
+    numInputs = modA->numInputs + modB->numInputs - external - internal;
+    numOutputs = modA->numOutputs + modB->numOutputs - internal;
+
+    //local connections
+    if (!argRead.noLocalConnections &&
+        log(double(Size())) / log(double(modType->Size())) * 100 > argRead.localConnectionCutOff) {
+        //phase 4: output connections
+        external = max(0, min(se + si, min(numInputs, numOutputs)));
+        int remainingInputs = numInputs - external;
+
+        //phase 5: convert to internal nets
+        internal = min(si, external);
+        si -= internal;
+        external -= internal;
+        se -= external;
+
+        //phase 6: combine inputs
+        inputCombinations = max(0, min(se, remainingInputs - 1));
+        external += inputCombinations;
+
+        numInputs -= external + internal;
+        numOutputs -= internal;
+    }
+
+    if (debug::On(debug::combine))
+        dout << "   pin counts: " << (modA->numInputs + modB->numInputs - numInputs) << " inputs and "
+             << (modA->numOutputs + modB->numOutputs - numOutputs) << " outputs eliminated" << endl;
+}
+
+void Module::StoreTreeData(Module *modA, Module *modB) {
     //store partitioning tree data
     number = ++Globals::moduleCounter;
-    Globals::treeData.push_back(
-            Globals::PtreeNode(number, modA->number, modB->number, weight, numBlocks, numInputs, numOutputs));
+    Statistics::Memory(Statistics::treeDataMemory, Statistics::ListNode(sizeof(Globals::PtreeNode)));
+    if (modA)
+        Globals::treeData.push_back(
+                Globals::PtreeNode(number, modA->number, modB->number, weight, numBlocks, numInputs, numOutputs));
+    else
+        Globals::treeData.push_back(Globals::PtreeNode(number, -1, -1, weight, numBlocks, numInputs, numOutputs));
 
     delete (modA);
     delete (modB);
 }
 
 void Module::Net::Join(InputNet *inputNet) {
-    //Add inputNet's sinks to this net
-    for (list<Terminal>::iterator ti = inputNet->sinks.begin(); ti != inputNet->sinks.end(); ++ti)
-        ti->first->inputs[ti->second] = this;
+    //Add inputNet's sinks to this net. The pins of a net with many sinks are not rewritten: they keep
+    //pointing to inputNet, which forwards to this net, so that a join takes constant time
+    if (inputNet->sinks.size() > rewriteLimit)
+        inputNet->parent = this;
+    else
+        for (list<Terminal>::iterator ti = inputNet->sinks.begin(); ti != inputNet->sinks.end(); ++ti)
+            ti->first->inputs[ti->second] = this;
     sinks.splice(sinks.end(), inputNet->sinks);
 }
 
-bool Module::InputNet::Join(InputNet *inputNet) {
-    Net::Join(inputNet);
+Module::Net *Module::Net::Find(Net *net) {
+    Net *root = net;
+    while (root->parent && root->parent != root)
+        root = root->parent;
+    //path compression
+    while (net != root && net->parent != root) {
+        Net *next = net->parent;
+        net->parent = root;
+        net = next;
+    }
+    return root;
+}
 
-    //update controllableOutputs
-    if (!argRead.allowLoops) {
-        //add inputNet's controllableOutputs to thisInput's controllableOutputs
-        for (map<OutputNet *, double>::iterator coi = inputNet->controllableOutputs.begin();
-             coi != inputNet->controllableOutputs.end(); ++coi)
-            controllableOutputs[coi->first] = max(controllableOutputs[coi->first], coi->second);
+//deletes an input net after it is joined, or keeps it for as long as pins point to it
+void Module::Discard(InputNet *inputNet) {
+    if (!inputNet->parent) {
+        delete inputNet;
+        return;
     }
+    Statistics::ControllableOutputs(-inputNet->controllableOutputs.size());
+    inputNet->controllableOutputs.Clear();
+    forwardingNets.push_back(inputNet);
+}
 
-    //update maxLength
-    requiredMinLength = max(requiredMinLength, inputNet->requiredMinLength);
-    allowedMaxLength = min(allowedMaxLength, inputNet->allowedMaxLength);
+//points every pin to the net it belongs to, and deletes the nets that were forwarding
+void Module::ResolvePins() {
+    if (forwardingNets.empty())
+        return;
+    for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
+        for (vector<Net *>::iterator ni = (*bi)->inputs.begin(); ni != (*bi)->inputs.end(); ++ni)
+            *ni = Net::Find(*ni);
+    for (list<InputNet *>::iterator ni = forwardingNets.begin(); ni != forwardingNets.end(); ++ni)
+        delete *ni;
+    forwardingNets.clear();
+}
 
-    delete inputNet;
+Module::InputNet::~InputNet() {
+    Statistics::ControllableOutputs(-long(controllableOutputs.size()));
+    Statistics::Memory(Statistics::netMemory, -Bytes());
+}
+
+bool Module::InputNet::Join(InputNet *inputNet, Module *module) {
+    Net::Join(inputNet);
+    PathTiming::MergeInputs(this, inputNet);
+    module->Discard(inputNet);
     return 1;
 }
 
-bool Module::OutputNet::Join(InputNet *inputNet, Module *modA, Module *modB, Module *modC, double delayScaleFactor,
-                             ModuleType *modType) {
-    bool allowed = 1;
+Module::OutputNet::Connection Module::OutputNet::Check(InputNet *inputNet, double delayScaleFactor) {
+    Connection connection = connectable;
     //check if connection is allowed -- i.e. no loops are being generated
-    if (!argRead.allowLoops && inputNet->controllableOutputs.find(this) != inputNet->controllableOutputs.end())
-        allowed = 0;
-
-    if (!argRead.allowLoops && !argRead.allowLongPaths) {
-        //check if path is not too long
-        if (maxLength > delayScaleFactor * inputNet->allowedMaxLength)
-            allowed = 0;
-        //check if path is not too short
-        if (maxLength < delayScaleFactor * inputNet->requiredMinLength)
-            return 0;
+    if (Loop(inputNet))
+        connection = needsFlop;
+
+    //check if the path is not too long or too short
+    if (PathTiming::On()) {
+        Connection timing = PathTiming::Check(this, inputNet, delayScaleFactor);
+        if (timing != connectable)
+            connection = timing;
     }
+    return connection;
+}
+
+bool Module::OutputNet::Loop(InputNet *inputNet) {
+    if (argRead.allowLoops)
+        return 0;
+    if (TopologicalOrder::On())
+        return TopologicalOrder::Loop(this, inputNet);
+    return inputNet->controllableOutputs.Find(this) != 0;
+}
+
+bool Module::OutputNet::Join(InputNet *inputNet, Module *modA, Module *modB, Module *modC, double delayScaleFactor,
+                             ModuleType *modType) {
+    Statistics::Count(Statistics::joinAttempts);
+    Connection connection = Check(inputNet, delayScaleFactor);
+    if (connection == tooShort)
+        return 0;
 
-    if (!allowed) {
+    if (connection == needsFlop) {
         if (!argRead.dontInsertFlops && Globals::flop &&
             log(double(modC->Size())) / log(double(modType->Size())) * 100 > argRead.flopCutOff &&
-            argRead.flopInsertProbability >= uniform())
+            argRead.flopInsertProbability >= uniform()) {
+            if (Trace::On()) {
+                TraceRecord record(TraceRecord::flopRecord, Globals::moduleCounter + 1);
+                record.flop.reason = Loop(inputNet) ? TraceRecord::loop : TraceRecord::longPath;
+                record.flop.blocks = modC->numBlocks;
+                record.flop.maxLength = maxLength;
+                record.flop.allowedMaxLength = inputNet->allowedMaxLength;
+                record.flop.delayScaleFactor = delayScaleFactor;
+                Trace::Write(record);
+            }
             AddFlop(modA, modB, modC);
-        else
+        } else
             return 0;
     }
 
+    if (TopologicalOrder::On())
+        TopologicalOrder::Connect(this, inputNet);
     Net::Join(inputNet);
 
-    //loop over all the controllable outputs of inputNet and update the maxLength if necessary
-    for (map<OutputNet *, double>::iterator coi = inputNet->controllableOutputs.begin();
-         coi != inputNet->controllableOutputs.end(); ++coi)
-        coi->first->maxLength = max(coi->first->maxLength, coi->second + maxLength);
-
-    //update controllableOutputs
-    if (!argRead.allowLoops && !argRead.allowLongPaths) {
-        //loop over all the inputs, and add inputNet's controllableOutputs if thisOutput belongs to their controllableOutputs
-        //also update the maxLengths of the inputs if necessary
-        for (Module *mod = modA; mod; mod = (mod == modA) ? modB : (mod == modB) ? modC : 0)
-            for (list<InputNet *>::iterator li = mod->inputs.begin(); li != mod->inputs.end(); ++li) {
-                map<OutputNet *, double>::iterator co = (*li)->controllableOutputs.find(this);
-                if (co != (*li)->controllableOutputs.end()) {
-                    for (map<OutputNet *, double>::iterator it = inputNet->controllableOutputs.begin();
-                         it != inputNet->controllableOutputs.end(); ++it)
-                        (*li)->controllableOutputs[it->first] = max((*li)->controllableOutputs[it->first],
-                                                                    co->second + it->second);
-                    double len = inputNet->allowedMaxLength - co->second;
-                    if (len < 0)
-                        throw ("Internal error: allowedMaxLength<0");
-                    if (len < (*li)->allowedMaxLength)
-                        (*li)->allowedMaxLength = len;
-
-                    len = max(0.0, inputNet->requiredMinLength - co->second);
-                    if (len > (*li)->requiredMinLength)
-                        (*li)->requiredMinLength = len;
-                }
-            }
-    }
+    if (PathTiming::On())
+        PathTiming::Connect(this, inputNet, modA, modB, modC);
 
-    delete inputNet;
+    Statistics::Count(Statistics::joinSuccesses);
+    modC->Discard(inputNet);
     return 1;
 }
 
 void Module::OutputNet::MakeInternal(Module *modA, Module *modB, Module *modC) {
-    if (!argRead.allowLoops) {
-        //loop over all the inputs, and remove this output (if it belongs to their controllableOutputs)
-        for (Module *mod = modA; mod; mod = (mod == modA) ? modB : (mod == modB) ? modC : 0)
-            for (list<InputNet *>::iterator li = mod->inputs.begin(); li != mod->inputs.end(); ++li)
-                (*li)->controllableOutputs.erase(this);
-    }
+    PathTiming::Remove(this, modA, modB, modC);
 }
 
 void Module::Merge(Module *
@@ -455,6 +647,13 @@ splice(internalNets
 end(),
 
 module->internalNets);
+forwardingNets.
+splice(forwardingNets
+.
+
+end(),
+
+module->forwardingNets);
 inputs.
 splice(inputs
 .
@@ -501,7 +700,8 @@ void Module::Block::CheckConsistency() {
         throw ("Internal error: number of block inputs does not match");
     for (unsigned int i = 0; i < inputs.size(); ++i) {
         int count = 0;
-        for (list<Terminal>::iterator ti = inputs[i]->sinks.begin(); ti != inputs[i]->sinks.end(); ++ti)
+        Net *net = Net::Find(inputs[i]);
+        for (list<Terminal>::iterator ti = net->sinks.begin(); ti != net->sinks.end(); ++ti)
             if (ti->first == this && ti->second == i)
                 ++count;
         if (count != 1)
@@ -512,12 +712,16 @@ void Module::Block::CheckConsistency() {
             throw ("Internal error: output terminal not attached to output net");
         if (outputs[o]->source.first != this || outputs[o]->source.second != o)
             throw ("Internal error: net does not point back to block output terminal");
+        if (TopologicalOrder::On() && !cell->Sequential())
+            for (list<Terminal>::iterator ti = outputs[o]->sinks.begin(); ti != outputs[o]->sinks.end(); ++ti)
+                if (!ti->first->cell->Sequential() && ti->first->order <= order)
+                    throw ("Internal error: combinational blocks not in topological order");
     }
 }
 
 void Module::Net::CheckConsistency() {
     for (list<Terminal>::iterator ti = sinks.begin(); ti != sinks.end(); ++ti)
-        if (ti->first->inputs[ti->second] != this)
+        if (Find(ti->first->inputs[ti->second]) != this)
             throw ("Internal error: block input terminal does not point back to net");
 }
 
@@ -532,6 +736,9 @@ void Module::OutputNet::CheckConsistency() {
 void Module::OutputNet::AddFlop(Module *modA, Module *modB, Module *modC) {
     //add flop
     Block *block = new Block(Globals::flop);
+    TopologicalOrder::Add(block);
+    Progress::BlockCreated();
+    Statistics::Count(Statistics::flopsInserted);
     modC->blocks.push_back(block);
     ++modC->numBlocks;
     modC->area += Globals::flop->Size();
@@ -544,15 +751,12 @@ void Module::OutputNet::AddFlop(Module *modA, Module *modB, Module *modC) {
     oNet->sinks.splice(oNet->sinks.begin(), sinks);
     //connect to flop input
     block->inputs[0] = oNet;
-    oNet->sinks.push_back(Terminal(block, 0));
+    oNet->AddSink(Terminal(block, 0));
     //connect this outputnet to flop output
     block->outputs[0] = this;
     source.first = block;
     source.second = 0;
     maxLength = 0;
 
-    //loop over all the inputs, and erase thisOutput from their controllableOutputs
-    for (Module *mod = modA; mod; mod = (mod == modA) ? modB : (mod == modB) ? modC : 0)
-        for (list<InputNet *>::iterator li = mod->inputs.begin(); li != mod->inputs.end(); ++li)
-            (*li)->controllableOutputs.erase(this);
+    PathTiming::Remove(this, modA, modB, modC);
 }
\ No newline at end of file
@@ -32,12 +32,21 @@
 #ifndef _H_Debug
 #define _H_Debug
 
+#include "argread.h"
+
+//debug categories compiled in (e.g. cmake -DGNL_DEBUG_MASK=0 removes all debug code)
+#ifndef GNL_DEBUG_MASK
+#define GNL_DEBUG_MASK (~0)
+#endif
+
 class debug {
 public:
     static const int combine = 1;
     static const int consistency = 2;
     static const int buckets = 4;
     static const int pathlength = 8;
+
+    static bool On(int category) { return (GNL_DEBUG_MASK & category) && (argRead.debugBits & category); }
 };
 
 #endif //{_H_Debug}
\ No newline at end of file
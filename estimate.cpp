@@ -0,0 +1,279 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "estimate.h"
+#include "argread.h"
+#include "pvtools.h"
+#include <cmath>
+
+//The memory model charges every heap object its glibc malloc chunk (request plus an 8 byte header,
+//rounded up to 16 bytes, at least 32 bytes) and every list/map element its node overhead. The model
+//describes the end of the top-level generation, when all blocks and nets exist and the writers run.
+//Flip-flops inserted to break loops or long paths are not known up front and are not included.
+
+void ResourceEstimator::Counts::Add(const Counts &c, double n) {
+    blocks += n * c.blocks;
+    inputPins += n * c.inputPins;
+    outputPins += n * c.outputPins;
+    modules += n * c.modules;
+    nameBytes += n * c.nameBytes;
+    blockBytes += n * c.blockBytes;
+    libraryCells.insert(c.libraryCells.begin(), c.libraryCells.end());
+}
+
+ResourceEstimator::ResourceEstimator(ModuleType *c) : circuit(c) {
+    Count(circuit, counts[circuit]);
+    CountInstances(circuit, 1);
+}
+
+void ResourceEstimator::CountInstances(ModuleType *modType, double n) {
+    instances[modType] += n;
+    list<int>::iterator di = modType->distribution.begin();
+    for (list<string>::iterator li = modType->libraries.begin(); li != modType->libraries.end(); ++li) {
+        list<Cell *> &cells = Globals::libraries[*li].cells;
+        for (list<Cell *>::iterator ci = cells.begin(); ci != cells.end(); ++ci, ++di) {
+            ModuleType *macroType = dynamic_cast<ModuleType *>(*ci);
+            if (macroType && *di)
+                CountInstances(macroType, n * *di);
+        }
+    }
+}
+
+void ResourceEstimator::Count(ModuleType *modType, Counts &c) {
+    list<int>::iterator di = modType->distribution.begin();
+    for (list<string>::iterator li = modType->libraries.begin(); li != modType->libraries.end(); ++li) {
+        list<Cell *> &cells = Globals::libraries[*li].cells;
+        for (list<Cell *>::iterator ci = cells.begin(); ci != cells.end(); ++ci, ++di) {
+            double n = *di;
+            c.leaves += n;
+            Librarycell *libcell = dynamic_cast<Librarycell *>(*ci);
+            ModuleType *macroType = dynamic_cast<ModuleType *>(*ci);
+            if (libcell) {
+                if (!n)
+                    continue;
+                c.blocks += n;
+                c.inputPins += n * libcell->I();
+                c.outputPins += n * libcell->O();
+                c.nameBytes += n * libcell->Name().size();
+                c.blockBytes += n * (Chunk(sizeof(Module::Block)) + ListNode(sizeof(Module::Block *)));
+                if (libcell->I())
+                    c.blockBytes += n * Chunk(libcell->I() * sizeof(Module::Net *));
+                if (libcell->O())
+                    c.blockBytes += n * Chunk(libcell->O() * sizeof(Module::OutputNet *));
+                c.libraryCells.insert(libcell);
+            } else if (macroType) {
+                map<ModuleType *, Counts>::iterator mi = counts.find(macroType);
+                if (mi == counts.end()) {
+                    mi = counts.insert(pair<ModuleType *const, Counts>(macroType, Counts())).first;
+                    Count(macroType, mi->second);
+                }
+                c.Add(mi->second, n);
+            } else
+                throw ("Internal error: cell should be libcell or macrocell");
+        }
+    }
+    //every combination creates a module, a tree of n leaves has 2n-1 nodes
+    if (c.leaves > 0)
+        c.modules += 2 * c.leaves - 1;
+}
+
+void ResourceEstimator::Write(ostream &out) {
+    Counts &c = counts[circuit];
+    double numInputs = circuit->I(), numOutputs = circuit->O();
+    double nets = c.outputPins + numInputs;
+    bool writers = 0, buckets = 0;
+    for (list<string>::iterator fi = argRead.outputFormats.begin(); fi != argRead.outputFormats.end(); ++fi) {
+        if (*fi == "dat" || *fi == "plot")
+            buckets = 1;
+        else if (*fi != "rtd" && *fi != "info")
+            writers = 1;
+    }
+
+    out << "Resource estimate for circuit " << circuit->Name() << " (dry run, no netlist generated)\n\n";
+    out << "Expected netlist:\n";
+    out << stringPrintf("   blocks:            %12.0f\n", c.blocks);
+    out << stringPrintf("   pins:              %12.0f   (%.0f inputs, %.0f outputs)\n", c.inputPins + c.outputPins,
+                        c.inputPins, c.outputPins);
+    out << stringPrintf("   nets:              %12.0f\n", nets);
+    out << stringPrintf("   modules:           %12.0f\n", c.modules);
+    for (map<ModuleType *, double>::iterator ii = instances.begin(); ii != instances.end(); ++ii)
+        if (ii->first != circuit)
+            out << stringPrintf("   instances of %-6s%12.0f\n", (ii->first->Name() + ":").c_str(), ii->second);
+
+    //controllable outputs: an input controls at most all outputs of its module, and the modules
+    //alive at the end are the circuit and the two halves it is combined from
+    double entries = 0;
+    if (!argRead.allowLoops) {
+        double meanT, meanI, meanO, meanG, sigmaT, sigmaG;
+        circuit->GetMeanIO(circuit->Size(), meanT, meanI, meanO, meanG, sigmaT, sigmaG);
+        entries = numInputs * numOutputs;
+        if (circuit->Size() > 1) {
+            circuit->GetMeanIO(circuit->Size() / 2.0, meanT, meanI, meanO, meanG, sigmaT, sigmaG);
+            entries += 2 * meanI * meanO;
+        }
+        //with -ap loops are found by a topological order of the blocks, without controllable outputs
+        if (argRead.allowLongPaths)
+            entries = 0;
+    }
+
+    double memBlocks = c.blockBytes;
+    double memNets = c.outputPins * (Chunk(sizeof(Module::OutputNet)) + ListNode(sizeof(Module::OutputNet *))) +
+                     numInputs * (Chunk(sizeof(Module::InputNet)) + ListNode(sizeof(Module::InputNet *)));
+    double memSinks = c.inputPins * ListNode(sizeof(Module::Terminal));
+    double memControllable = entries * sizeof(DelayVector<Module::OutputNet>::Entry);
+    double memTree = (2 * c.leaves - 1) * ModuleType::PartitionTree::nodeBytes + c.leaves * sizeof(Cell *);
+    if (buckets)
+        memTree += (2 * c.leaves - 1) * ListNode(sizeof(int));
+    double memTreeData = c.modules * ListNode(sizeof(Globals::PtreeNode));
+    double memWriters = writers ? max(nets, c.blocks) * MapNode(sizeof(pair<void *const, int>)) : 0;
+    double memTotal = memBlocks + memNets + memSinks + memControllable + memTree + memTreeData + memWriters;
+
+    out << "\nEstimated peak memory:\n";
+    out << "   blocks:            " << Size(memBlocks) << endl;
+    out << "   nets:              " << Size(memNets) << endl;
+    out << "   sinks:             " << Size(memSinks) << endl;
+    out << "   controllable outs: " << Size(memControllable) << "   (upper bound, " <<
+        stringPrintf("%.0f", entries) << " entries)\n";
+    out << "   partition tree:    " << Size(memTree) << endl;
+    out << "   tree data:         " << Size(memTreeData) << endl;
+    out << "   output writers:    " << Size(memWriters) << endl;
+    out << "   total:             " << Size(memTotal - memControllable) << "   (up to " <<
+        Size(memTotal).substr(Size(memTotal).find_first_not_of(' ')) << ")\n";
+
+    out << "\nEstimated output files:\n";
+    double fileTotal = 0;
+    for (list<string>::iterator fi = argRead.outputFormats.begin(); fi != argRead.outputFormats.end(); ++fi) {
+        double size = FileSize(*fi, circuit, c);
+        fileTotal += size;
+        out << stringPrintf("   %-18s ", (circuit->Name() + "." + *fi).c_str()) << Size(size) << endl;
+    }
+    for (map<ModuleType *, double>::iterator ii = instances.begin(); ii != instances.end(); ++ii) {
+        if (ii->first == circuit)
+            continue;
+        for (list<string>::iterator fi = argRead.outputMacrocellFormats.begin();
+             fi != argRead.outputMacrocellFormats.end(); ++fi) {
+            double size = ii->second * FileSize(*fi, ii->first, counts[ii->first]);
+            fileTotal += size;
+            out << stringPrintf("   %-18s ", (ii->first->Name() + "_*." + *fi).c_str()) << Size(size) <<
+                stringPrintf("   (%.0f files)\n", ii->second);
+        }
+    }
+    out << "   total:             " << Size(fileTotal) << endl;
+    out << "\nFlip-flops inserted to break loops and long paths are not included.\n";
+}
+
+double ResourceEstimator::FileSize(const string &format, ModuleType *modType, const Counts &c) {
+    double numInputs = modType->I(), numOutputs = modType->O(), pads = numInputs + numOutputs;
+    double nets = c.outputPins + numInputs, pins = c.inputPins + c.outputPins;
+    double netDigits = AverageDigits(nets), cellDigits = AverageDigits(c.blocks);
+    double padDigits = AverageDigits(pads + 1), moduleDigits = AverageDigits(c.modules);
+    double nameLength = modType->Name().size() + 3;
+    double header = HeaderSize(modType);
+    double averageName = c.blocks > 0 ? c.nameBytes / c.blocks : 0;
+
+    if (format == "hnl")
+        return 60 + nameLength + header + 45 * c.libraryCells.size() + nameLength + 20 + (pads + pins) * (2 + netDigits) +
+               c.nameBytes + c.blocks;
+    if (format == "netD")
+        return 30 + (c.inputPins + c.outputPins) * (6 + cellDigits) + pads * (6 + padDigits);
+    if (format == "netD2")
+        return 30 + 2 * (c.inputPins + numOutputs) * (6 + cellDigits);
+    if (format == "nets")
+        //both the .nodes and the .nets file
+        return 2 * (80 + nameLength + header) + 2 * pads * (13 + padDigits) + c.nameBytes + c.blocks * (2 + cellDigits) +
+               nets * 15 + pins * (averageName + 4 + cellDigits);
+    if (format == "info")
+        return 60 + nameLength + header;
+    if (format == "json")
+        return 1000;
+    if (format == "plot")
+        return 850 + 9 * nameLength;
+    if (format == "rtd")
+        return 200 + 2 * argRead.ar_commandLine.size() + 33 * RtdLines(modType);
+    if (format == "dat")
+        return 300 + 2 * argRead.ar_commandLine.size() + 140 * (modType->regions.size() +
+                                                                  log(double(modType->Size())) /
+                                                                  log(double(argRead.correctionBucketFactor)) / 2);
+    if (format == "tree")
+        return 60 + nameLength + header + c.blocks * (1 + moduleDigits) + c.modules * 3 * (1 + moduleDigits);
+    if (format == "ptree")
+        return 60 + nameLength + header + c.modules * (2 * (1 + moduleDigits) + 10);
+    return 0;
+}
+
+//Number of (B,T) pairs in the rtd file. For random combinations about 2n/(b(b+1)) of the modules
+//have b blocks; their T values spread over about six standard deviations.
+double ResourceEstimator::RtdLines(ModuleType *modType) {
+    double n = modType->Size(), lines = 0;
+    for (double b = 1; b <= n; ++b) {
+        double modules = 2 * n / (b * (b + 1));
+        if (modules < 0.1) {
+            //the remaining modules all have a size of their own
+            lines += 2 * n / b;
+            break;
+        }
+        double meanT, meanI, meanO, meanG, sigmaT, sigmaG;
+        modType->GetMeanIO(b, meanT, meanI, meanO, meanG, sigmaT, sigmaG);
+        double values = 6 * sigmaT + 1;
+        lines += values * (1 - exp(-modules / values));
+    }
+    return lines;
+}
+
+double ResourceEstimator::HeaderSize(ModuleType *modType) {
+    double regions = modType->regions.size();
+    //size of the info header, plus the comment prefix written in front of every line
+    return argRead.ar_commandLine.size() + 160 + 100 + 170 * (regions - 1) + 2 * (14 + 8 * (regions - 1));
+}
+
+double ResourceEstimator::Chunk(double bytes) {
+    return max(32.0, ceil((bytes + 8) / 16) * 16);
+}
+
+//average number of decimal digits of the numbers 0 .. n-1
+double ResourceEstimator::AverageDigits(double n) {
+    if (n < 1)
+        return 1;
+    double total = 0, low = 0, high = 10;
+    for (int digits = 1; low < n; ++digits, low = high, high *= 10)
+        total += (min(high, n) - low) * digits;
+    return total / n;
+}
+
+string ResourceEstimator::Size(double bytes) {
+    if (bytes < 10000)
+        return stringPrintf("%10.0f  B", bytes);
+    if (bytes < 1e7)
+        return stringPrintf("%10.1f kB", bytes / 1024);
+    if (bytes < 1e10)
+        return stringPrintf("%10.1f MB", bytes / 1024 / 1024);
+    return stringPrintf("%10.1f GB", bytes / 1024 / 1024 / 1024);
+}
@@ -0,0 +1,91 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Estimate
+#define _H_Estimate
+
+#include <iostream>
+#include <string>
+#include <set>
+#include "main.h"
+
+using namespace std;
+
+//Up-front estimate of the size of a generation run, computed from the parsed gnl file only:
+//expected number of blocks, pins and nets, peak memory and the size of the output files.
+class ResourceEstimator {
+public:
+    ResourceEstimator(ModuleType *circuit);
+
+    void Write(ostream &out);
+
+private:
+    //expected counts for a single instance of a module type (macrocells expanded)
+    struct Counts {
+        Counts() : blocks(0), inputPins(0), outputPins(0), leaves(0), modules(0), nameBytes(0), blockBytes(0) {}
+
+        void Add(const Counts &c, double n);
+
+        double blocks;
+        double inputPins, outputPins;
+        double leaves;          //cells in the distribution, i.e. leaves of the partition tree
+        double modules;         //modules created, i.e. lines in the tree data
+        double nameBytes;       //sum of the cell name lengths over all blocks
+        double blockBytes;      //heap memory of the blocks, including their pin vectors
+        set<Librarycell *> libraryCells;
+    };
+
+    void Count(ModuleType *modType, Counts &c);
+
+    void CountInstances(ModuleType *modType, double n);
+
+    double FileSize(const string &format, ModuleType *modType, const Counts &c);
+
+    double RtdLines(ModuleType *modType);
+
+    double HeaderSize(ModuleType *modType);
+
+    static double Chunk(double bytes);
+
+    static double ListNode(double bytes) { return Chunk(2 * sizeof(void *) + bytes); }
+
+    static double MapNode(double bytes) { return Chunk(4 * sizeof(void *) + bytes); }
+
+    static double AverageDigits(double n);
+
+    static string Size(double bytes);
+
+    ModuleType *circuit;
+    map<ModuleType *, Counts> counts;
+    map<ModuleType *, double> instances;
+};
+
+#endif //{_H_Estimate}
@@ -0,0 +1,258 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "main.h"
+#include "argread.h"
+#include "pvtools.h"
+#include "statistics.h"
+#include "topology.h"
+#include <strings.h>
+
+thread_local map<string, Library> Globals::libraries;
+thread_local Librarycell *Globals::flop = 0;
+thread_local ModuleType *Globals::circuit = 0;
+thread_local int Globals::progress;
+thread_local map<string, list<string> > Globals::hierarchy;
+thread_local vector<NetlistVisitor *> Globals::visitors;
+string Globals::version = "1.1.1";
+thread_local DelayDistrib Globals::delays;
+thread_local vector<double> Globals::targetDelayDistrib;
+thread_local int Globals::moduleCounter = 0;
+thread_local list<Globals::PtreeNode> Globals::treeData;
+thread_local list<Globals::RegionOverride> Globals::regionOverrides;
+
+
+void Globals::Clear() {
+    delete circuit;
+    circuit = 0;
+    flop = 0;
+    libraries.clear();
+    hierarchy.clear();
+    visitors.clear();
+    moduleCounter = 0;
+    TopologicalOrder::Clear();
+    Statistics::Memory(Statistics::treeDataMemory, -long(treeData.size()) * Statistics::ListNode(sizeof(PtreeNode)));
+    treeData.clear();
+    regionOverrides.clear();
+}
+
+void InitializeGenerator() {
+    if (argRead.delayShapeDistribution.empty())
+        Globals::delays.InitDelta(argRead.maxPathLength);
+    else
+        Globals::delays.InitShape(argRead.maxPathLength, argRead.delayShapeDistribution);
+
+    randomSeed(argRead.seed);
+    Statistics::Reset();
+    string error;
+    if (argRead.perfCounters && !PerfCounters::Open(error))
+        lout << "Hardware performance counters not available (" << error << "), continuing without them.\n";
+}
+
+string OutputFileName(const string &name, const char *extension) {
+    string fileName = name + "." + extension;
+    return argRead.outputDir.empty() ? fileName : argRead.outputDir + "/" + fileName;
+}
+
+void ParseGnlFile() {
+    PhaseTimer timer(Statistics::parse);
+    LineParser parser(argRead.gnlFile.c_str());
+    lout << "Parsing gnl file " << argRead.gnlFile.c_str() << ".\n";
+    string section;
+    bool linesSkipped;
+    try {
+        while (parser.ReadNextSection(section, linesSkipped)) {
+            if (linesSkipped)
+                throw ("syntax error before section header");
+            string key, value;
+            if (!strcasecmp(section.c_str(), "library")) {
+                string name;
+                list<Cell *> cells;
+                list<string> words;
+                while (parser.ReadKey(key, value)) {
+                    parser.SplitIntoWords(value, words);
+                    if (words.empty())
+                        throw ("value expected");
+                    if (!strcasecmp(key.c_str(), "name"))
+                        name = words.front();
+                    else if (!strcasecmp(key.c_str(), "gate") || !strcasecmp(key.c_str(), "latch")) {
+                        if (words.size() < 3)
+                            throw ("{gate|latch}=<name> <num inputs> <num outputs> [<area> [<delay>]] expected");
+                        list<string>::iterator si = words.begin();
+                        int i = atoi((++si)->c_str()), o = atoi((++si)->c_str()), area = 1;
+                        if (++si != words.end()) {
+                            area = atoi(si->c_str());
+                            if (area <= 0)
+                                throw ("area <= 0");
+                        }
+                        double delay = 1;
+                        if (si != words.end() && ++si != words.end()) {
+                            delay = atof(si->c_str());
+                            if (delay <= 0)
+                                throw ("delay <= 0");
+                        }
+                        Librarycell *newCell = new Librarycell(words.front(), i, o, !strcasecmp(key.c_str(), "latch"),
+                                                               area, delay);
+                        cells.push_back(newCell);
+                        if (!Globals::flop && i == 1 && o == 1 && newCell->Sequential())
+                            Globals::flop = newCell;
+                    } else
+                        throw ("syntax error");
+                }
+                if (name.empty())
+                    throw ("library name not specified");
+                if (Globals::libraries.find(name) != Globals::libraries.end())
+                    throw ("library name already in use");
+                Globals::libraries[name].cells = cells;
+            } else if (!strcasecmp(section.c_str(), "circuit") || !strcasecmp(section.c_str(), "module")) {
+                ModuleType *modType = new ModuleType;
+                ModuleType::Region region;
+                int numCells = 0, libCells = 0;
+                int regionBound = -1;
+                list<string> words;
+                while (parser.ReadKey(key, value)) {
+                    parser.SplitIntoWords(value, words);
+                    if (words.empty())
+                        throw ("value expected");
+                    if (!strcasecmp(key.c_str(), "name"))
+                        modType->name = words.front();
+                    else if (!strcasecmp(key.c_str(), "libraries")) {
+                        for (list<string>::iterator si = words.begin(); si != words.end(); ++si) {
+                            map<string, Library>::iterator mi = Globals::libraries.find(*si);
+                            if (mi == Globals::libraries.end())
+                                throw ("Unkown library or module: " + (*si));
+                            libCells += mi->second.cells.size();
+                        }
+                        modType->libraries.splice(modType->libraries.end(), words);
+                    } else if (!strcasecmp(key.c_str(), "distribution")) {
+                        for (list<string>::iterator si = words.begin(); si != words.end(); ++si) {
+                            modType->distribution.push_back(atoi(si->c_str()));
+                            ++numCells;
+                        }
+                    } else if (!strcasecmp(key.c_str(), "size")) {
+                        if (regionBound >= 1) {
+                            modType->regions[regionBound] = region;
+                            region = ModuleType::Region();
+                        }
+                        if (words.empty() || (regionBound = atoi(words.front().c_str())) < 1)
+                            throw ("region boundary size expected");
+                    } else if (!strcasecmp(key.c_str(), "meanT")) {
+                        region.meanT = atof(words.front().c_str());
+                    } else if (!strcasecmp(key.c_str(), "sigmaT")) {
+                        region.sigmaT = atof(words.front().c_str());
+                    } else if (!strcasecmp(key.c_str(), "p")) {
+                        region.p = atof(words.front().c_str());
+                    } else if (!strcasecmp(key.c_str(), "q")) {
+                        region.q = atof(words.front().c_str());
+                    } else if (!strcasecmp(key.c_str(), "meanG")) {
+                        region.meanG = atof(words.front().c_str());
+                    } else if (!strcasecmp(key.c_str(), "sigmaG")) {
+                        region.sigmaG = atof(words.front().c_str());
+                    } else if (!strcasecmp(key.c_str(), "I")) {
+                        modType->numInputs = atoi(words.front().c_str());
+                    } else if (!strcasecmp(key.c_str(), "O")) {
+                        modType->numOutputs = atoi(words.front().c_str());
+                    } else
+                        throw ("syntax error");
+                }
+                if (regionBound >= 1)
+                    modType->regions[regionBound] = region;
+                if (libCells != numCells)
+                    throw ("number of cells in distribution does not match with number of library cells");
+                if (modType->regions.empty())
+                    throw ("no Rent regions specified");
+                string typeName = modType->name;
+                if (typeName.empty() && strcasecmp(section.c_str(), "module"))
+                    typeName = "top";
+                for (list<Globals::RegionOverride>::iterator oi = Globals::regionOverrides.begin();
+                     oi != Globals::regionOverrides.end(); ++oi) {
+                    if (oi->module != typeName)
+                        continue;
+                    map<int, ModuleType::Region>::iterator ri = modType->regions.find(oi->size);
+                    if (ri == modType->regions.end())
+                        throw (stringPrintf("no region with size %d to override", oi->size));
+                    //meanT/p and sigmaT/q exclude each other: clear the one that is not overridden
+                    if (!strcasecmp(oi->parameter.c_str(), "meanT")) {
+                        ri->second.meanT = oi->value;
+                        ri->second.p = ModuleType::Region().p;
+                    } else if (!strcasecmp(oi->parameter.c_str(), "p")) {
+                        ri->second.p = oi->value;
+                        ri->second.meanT = ModuleType::Region().meanT;
+                    } else if (!strcasecmp(oi->parameter.c_str(), "sigmaT")) {
+                        ri->second.sigmaT = oi->value;
+                        ri->second.q = ModuleType::Region().q;
+                    } else if (!strcasecmp(oi->parameter.c_str(), "q")) {
+                        ri->second.q = oi->value;
+                        ri->second.sigmaT = ModuleType::Region().sigmaT;
+                    } else if (!strcasecmp(oi->parameter.c_str(), "meanG"))
+                        ri->second.meanG = oi->value;
+                    else if (!strcasecmp(oi->parameter.c_str(), "sigmaG"))
+                        ri->second.sigmaG = oi->value;
+                    else
+                        throw ("unknown region parameter " + oi->parameter);
+                    ++oi->applied;
+                }
+                {
+                    PhaseTimer timer(Statistics::completeRegions);
+                    modType->CompleteRegions();
+                }
+
+                if (!strcasecmp(section.c_str(), "module")) {
+                    if (modType->name.empty())
+                        throw ("module name not specified");
+                    if (Globals::libraries.find(modType->name) != Globals::libraries.end())
+                        throw ("module name already in use");
+                    Globals::libraries[modType->name].cells.push_back(modType);
+                } else {
+                    if (modType->name.empty())
+                        modType->name = "top";
+                    if (Globals::circuit)
+                        throw ("circuit already specified in gnl file");
+                    Globals::circuit = modType;
+                }
+            } else
+                throw ("unknown section type [" + section + "]");
+        }
+        if (!Globals::circuit)
+            throw ("no circuit specified in gnl file");
+        for (list<Globals::RegionOverride>::iterator oi = Globals::regionOverrides.begin();
+             oi != Globals::regionOverrides.end(); ++oi)
+            if (!oi->applied)
+                throw ("unknown module " + oi->module + " in region override");
+    }
+    catch (const char *msg) {
+        throw (stringPrintf("%s:%d: %s", argRead.gnlFile.c_str(), parser.LineNumber(), msg));
+    }
+    catch (const string &msg) {
+        throw (stringPrintf("%s:%d: %s", argRead.gnlFile.c_str(), parser.LineNumber(), msg.c_str()));
+    }
+}
+
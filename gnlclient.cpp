@@ -0,0 +1,140 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+//gnlclient: send a generation request to a gnl server (gnl -server <socket>)
+//
+//  gnlclient <socket> [options] <XX.gnl>
+//  gnlclient <socket> -shutdown
+//
+//The server generates as gnl [options] <XX.gnl> would in the working directory of the client: relative
+//paths are taken from there and the output files are written there (or to -od <dir>). Prints the result
+//and the timing, and exits with 0 if the generation succeeded
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <iostream>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+static bool SendAll(int fd, const string &text) {
+    for (size_t sent = 0; sent < text.size();) {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        sent += n;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: gnlclient <socket> [options] <XX.gnl>\n"
+                "       gnlclient <socket> -shutdown\n";
+        return 1;
+    }
+
+    string request;
+    if (argc == 3 && !strcmp(argv[2], "-shutdown"))
+        request = "shutdown\n";
+    else {
+        char cwd[PATH_MAX];
+        if (!getcwd(cwd, sizeof(cwd))) {
+            cerr << "Can't get the working directory: " << strerror(errno) << "\n";
+            return 1;
+        }
+        request = string("cwd ") + cwd + "\n";
+        for (int i = 2; i < argc; ++i) {
+            if (strchr(argv[i], '\n')) {
+                cerr << "Argument " << (i - 1) << " holds a new line\n";
+                return 1;
+            }
+            request += string("arg ") + argv[i] + "\n";
+        }
+    }
+    request += "\n";
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(argv[1]) >= sizeof(address.sun_path)) {
+        cerr << "Socket path " << argv[1] << " is too long\n";
+        return 1;
+    }
+    strcpy(address.sun_path, argv[1]);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *) &address, sizeof(address))) {
+        cerr << "Can't connect to a gnl server on " << argv[1] << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    if (!SendAll(fd, request)) {
+        cerr << "Can't send the request: " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    //the response, until "end"
+    string response, line;
+    bool ok = 0, ended = 0;
+    char chunk[4096];
+    while (!ended) {
+        size_t end = response.find('\n');
+        if (end == string::npos) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            response.append(chunk, n);
+            continue;
+        }
+        line = response.substr(0, end);
+        response.erase(0, end + 1);
+        if (line == "end")
+            ended = 1;
+        else {
+            if (line == "status ok")
+                ok = 1;
+            cout << line << "\n";
+        }
+    }
+    close(fd);
+    if (!ended) {
+        cerr << "The server closed the connection before the end of the response\n";
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+//gnlshm: read a netlist that gnl published in shared memory (gnl -w shm)
+//
+//  gnlshm <circuit> [summary|check|remove]
+//
+//summary (default) prints the size of the netlist, check verifies that the blocks and the nets of the
+//netlist agree with each other, remove removes the segment
+
+#include "shm.h"
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+static bool Fail(const string &circuit, const char *msg, long item) {
+    cerr << ShmNetlist::SegmentName(circuit) << ": " << msg << " " << item << "\n";
+    return 0;
+}
+
+static bool Check(const ShmNetlist &netlist, const string &circuit) {
+    const ShmHeader &h = netlist.Header();
+    vector<int> sinkPins(h.numNets);
+    uint64_t pins = 0;
+    for (int b = 0; b < h.numBlocks; ++b) {
+        int cell = netlist.BlockCell(b);
+        if (cell < 0 || cell >= h.numCells)
+            return Fail(circuit, "unknown cell on block", b);
+        const ShmCell &c = netlist.Cell(cell);
+        if (netlist.NumPins(b) != c.numInputs + c.numOutputs)
+            return Fail(circuit, "wrong number of pins on block", b);
+        const int32_t *nets = netlist.Pins(b);
+        for (int p = 0; p < netlist.NumPins(b); ++p) {
+            if (nets[p] < 0 || nets[p] >= h.numNets)
+                return Fail(circuit, "unknown net on a pin of block", b);
+            if (p < c.numInputs)
+                ++sinkPins[nets[p]];
+            else if (netlist.Source(nets[p]).block != b || netlist.Source(nets[p]).pin != p - c.numInputs)
+                return Fail(circuit, "net not driven by the output pin of block", b);
+        }
+        pins += netlist.NumPins(b);
+    }
+    if (pins != h.numPins)
+        return Fail(circuit, "wrong number of block pins:", pins);
+    for (int n = 0; n < h.numNets; ++n) {
+        ShmNetKind kind = netlist.Kind(n);
+        if ((n < h.numInputs) != (kind == shmInput) || (n >= h.numInputs && n < h.numInputs + h.numOutputs) !=
+                                                       (kind == shmOutput))
+            return Fail(circuit, "wrong kind of net", n);
+        if ((kind == shmInput) != (netlist.Source(n).block < 0))
+            return Fail(circuit, "wrong source of net", n);
+        if (netlist.NumSinks(n) != sinkPins[n])
+            return Fail(circuit, "sinks not on the block pins of net", n);
+        const ShmPin *sinks = netlist.Sinks(n);
+        for (int s = 0; s < netlist.NumSinks(n); ++s)
+            if (sinks[s].block < 0 || sinks[s].block >= h.numBlocks || sinks[s].pin < 0 ||
+                sinks[s].pin >= netlist.Cell(netlist.BlockCell(sinks[s].block)).numInputs ||
+                netlist.Pins(sinks[s].block)[sinks[s].pin] != n)
+                return Fail(circuit, "sink not on an input pin of the net", n);
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: gnlshm <circuit> [summary|check|remove]\n";
+        return 1;
+    }
+    string circuit = argv[1];
+    string action = argc == 3 ? argv[2] : "summary";
+    if (action == "remove") {
+        if (ShmNetlist::Remove(circuit))
+            return 0;
+        cerr << "Can't remove shared memory segment " << ShmNetlist::SegmentName(circuit) << "\n";
+        return 1;
+    }
+    if (action != "summary" && action != "check") {
+        cerr << "Unknown action " << action << "\n";
+        return 1;
+    }
+
+    ShmNetlist netlist;
+    string error;
+    if (!netlist.Open(circuit, error)) {
+        cerr << error << "\n";
+        return 1;
+    }
+    const ShmHeader &h = netlist.Header();
+    if (action == "check") {
+        if (!Check(netlist, circuit))
+            return 1;
+        printf("%s: netlist is consistent\n", ShmNetlist::SegmentName(circuit).c_str());
+        return 0;
+    }
+
+    int unlisted = 0;
+    for (int n = 0; n < h.numNets; ++n)
+        unlisted += netlist.Kind(n) == shmUnlisted;
+    printf("segment   %s (%llu bytes)\n", ShmNetlist::SegmentName(circuit).c_str(), (unsigned long long) h.size);
+    printf("cells     %d\n", h.numCells);
+    for (int c = 0; c < h.numCells; ++c)
+        printf("          %s %d %d area %d%s\n", netlist.CellName(c), netlist.Cell(c).numInputs,
+               netlist.Cell(c).numOutputs, netlist.Cell(c).area, netlist.Cell(c).sequential ? " sequential" : "");
+    printf("blocks    %d\n", h.numBlocks);
+    printf("inputs    %d\n", h.numInputs);
+    printf("outputs   %d\n", h.numOutputs);
+    printf("nets      %d (%d feeding inserted flops)\n", h.numNets, unlisted);
+    printf("pins      %llu\n", (unsigned long long) h.numPins);
+    printf("sinks     %llu\n", (unsigned long long) h.numSinks);
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+//gnltrace: convert a binary gnl trace (gnl -trace <file>) into CSV
+//
+//  gnltrace <trace file> [combine|flop]
+//
+//writes the combine records (default) or the flop records to stdout
+
+#include "trace.h"
+#include <cstdio>
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: gnltrace <trace file> [combine|flop]\n";
+        return 1;
+    }
+    string kind = argc == 3 ? argv[2] : "combine";
+    int type;
+    if (kind == "combine")
+        type = TraceRecord::combineRecord;
+    else if (kind == "flop")
+        type = TraceRecord::flopRecord;
+    else {
+        cerr << "Unknown record type " << kind << "\n";
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        cerr << "Can't open file " << argv[1] << " for reading\n";
+        return 1;
+    }
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, "GNLTRACE", 8)) {
+        cerr << argv[1] << " is not a gnl trace\n";
+        return 1;
+    }
+    if (header.version != Trace::version || header.recordSize != sizeof(TraceRecord)) {
+        cerr << argv[1] << ": trace version " << header.version << " is not supported\n";
+        return 1;
+    }
+
+    if (type == TraceRecord::combineRecord)
+        printf("run,module,moduleA,moduleB,blocksA,blocksB,ia,oa,ib,ob,targetI,targetO,se,si,aToB,bToA,internal,"
+               "inputCombinations,localOutputs,localInternal,localInputs,joinAttempts,flops,resultI,resultO\n");
+    else
+        printf("run,module,reason,blocks,maxLength,allowedMaxLength,delayScaleFactor\n");
+
+    TraceRecord r(0, 0);
+    while (fread(&r, sizeof(r), 1, in) == 1) {
+        if (r.type != type)
+            continue;
+        if (type == TraceRecord::combineRecord) {
+            TraceRecord::Combine &c = r.combine;
+            printf("%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", r.run, r.module,
+                   c.moduleA, c.moduleB, c.blocksA, c.blocksB, c.ia, c.oa, c.ib, c.ob, c.targetI, c.targetO, c.se,
+                   c.si, c.aToB, c.bToA, c.internal, c.inputCombinations, c.localOutputs, c.localInternal,
+                   c.localInputs, c.joinAttempts, c.flops, c.resultI, c.resultO);
+        } else {
+            TraceRecord::Flop &f = r.flop;
+            printf("%d,%d,%s,%d,%g,%g,%g\n", r.run, r.module, f.reason == TraceRecord::loop ? "loop" : "longPath",
+                   f.blocks, f.maxLength, f.allowedMaxLength, f.delayScaleFactor);
+        }
+    }
+    fclose(in);
+    return 0;
+}
@@ -0,0 +1,206 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "libgnl.h"
+#include "main.h"
+#include "argread.h"
+#include "scheduler.h"
+#include "checkpoint.h"
+
+void GnlSpec::BeginLibrary(const string &name) {
+    text += "\n[library]\nname=" + name + "\n";
+}
+
+void GnlSpec::AddCell(const char *kind, const string &name, int inputs, int outputs, int area, double delay) {
+    char buf[64];
+    sprintf(buf, " %d %d %d %g\n", inputs, outputs, area, delay);
+    text += string(kind) + "=" + name + buf;
+}
+
+void GnlSpec::AddGate(const string &name, int inputs, int outputs, int area, double delay) {
+    AddCell("gate", name, inputs, outputs, area, delay);
+}
+
+void GnlSpec::AddLatch(const string &name, int inputs, int outputs, int area, double delay) {
+    AddCell("latch", name, inputs, outputs, area, delay);
+}
+
+void GnlSpec::BeginModule(const string &name) {
+    text += "\n[module]\nname=" + name + "\n";
+}
+
+void GnlSpec::BeginCircuit(const string &name) {
+    text += "\n[circuit]\nname=" + name + "\n";
+}
+
+void GnlSpec::Set(const string &key, const string &value) {
+    text += key + "=" + value + "\n";
+}
+
+const Librarycell *GnlBlock::Cell() const {
+    return block->cell;
+}
+
+int GnlBlock::NumInputs() const {
+    return block->inputs.size();
+}
+
+int GnlBlock::NumOutputs() const {
+    return block->outputs.size();
+}
+
+GnlNet GnlBlock::Input(int i) const {
+    return block->inputs[i];
+}
+
+GnlNet GnlBlock::Output(int o) const {
+    return block->outputs[o];
+}
+
+bool GnlNet::Driven() const {
+    return net->Driven();
+}
+
+GnlPin GnlNet::Source() const {
+    if (!net->Driven())
+        throw string("libgnl: the source of a net driven by a circuit input");
+    return static_cast<Module::OutputNet *>(net)->source;
+}
+
+GnlNet::PinRange GnlNet::Sinks() const {
+    return net->sinks;
+}
+
+GnlNetlist::~GnlNetlist() {
+    delete module;
+    delete circuit;
+}
+
+void GnlGenerator::SetFile(const string &gnlFile) {
+    file = gnlFile;
+    specText.clear();
+}
+
+void GnlGenerator::SetSpec(const GnlSpec &spec) {
+    specText = spec.Text();
+    file.clear();
+}
+
+GnlNetlist *GnlGenerator::Generate() {
+    GnlNetlist *netlist = 0;
+    string error;
+    //argRead and Globals are per thread: the generation gets a context of its own
+    thread worker(&GnlGenerator::Run, this, ref(netlist), ref(error));
+    worker.join();
+    if (!netlist)
+        throw error;
+    return netlist;
+}
+
+void GnlGenerator::Run(GnlNetlist *&netlist, string &error) {
+    string gnlFile = file;
+    if (!specText.empty()) {
+        char name[] = "/tmp/libgnl.XXXXXX";
+        int fd = mkstemp(name);
+        if (fd < 0 || write(fd, specText.data(), specText.size()) != ssize_t(specText.size())) {
+            if (fd >= 0) {
+                close(fd);
+                unlink(name);
+            }
+            error = "libgnl: could not write the specification to a temporary file";
+            return;
+        }
+        close(fd);
+        gnlFile = name;
+    }
+    if (gnlFile.empty()) {
+        error = "libgnl: no gnl file or specification given";
+        return;
+    }
+
+    GnlNetlist *result = new GnlNetlist;
+    try {
+        vector<char *> args;
+        args.push_back(const_cast<char *>("gnl"));
+        for (vector<string>::iterator oi = options.begin(); oi != options.end(); ++oi)
+            args.push_back(const_cast<char *>(oi->c_str()));
+        args.push_back(const_cast<char *>(gnlFile.c_str()));
+        argRead.AR_ReadArgs(args.size(), &args[0]);
+        if (argRead.writeAllModules)
+            argRead.outputMacrocellFormats = argRead.outputFormats;
+        Globals::visitors = visitors;
+
+        InitializeGenerator();
+        ParseGnlFile();
+        if (!argRead.sweepFile.empty() || argRead.dryRun)
+            throw ("libgnl: -sweep and -dry generate no netlist");
+
+        if (Checkpoint::On())
+            Checkpoint::Begin();
+        if (MacrocellScheduler::On())
+            MacrocellScheduler::Run(args.size(), &args[0]);
+        result->module = Globals::circuit->GetInstance();
+        MacrocellScheduler::Clear();
+        Checkpoint::End();
+
+        //the netlist takes over the module, the circuit and the cells its blocks point to
+        result->name = Globals::circuit->InstanceName();
+        result->circuit = Globals::circuit;
+        result->libraries.swap(Globals::libraries);
+        result->hierarchy.swap(Globals::hierarchy);
+        Globals::circuit = 0;
+        netlist = result;
+    }
+    catch (int e) {
+        error = "libgnl: invalid options";
+    }
+    catch (const char *msg) {
+        error = msg;
+    }
+    catch (const string &msg) {
+        error = msg;
+    }
+    catch (...) {
+        error = "libgnl: internal error";
+    }
+    //the macrocell workers and the checkpoint read the gnl file too: it is removed at the end
+    if (!specText.empty())
+        unlink(gnlFile.c_str());
+    if (!netlist) {
+        MacrocellScheduler::Clear();
+        delete result;
+    }
+    Globals::Clear();
+}
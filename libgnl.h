@@ -0,0 +1,257 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Libgnl
+#define _H_Libgnl
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include "libraries.h"
+#include "modules.h"
+#include "visitor.h"
+
+using namespace std;
+
+//libgnl: gnl as a library. A GnlGenerator takes the specification (a .gnl file or a GnlSpec) and the
+//options of the command line, and generates the circuit on a thread of its own. The options (argRead)
+//and the generator state (Globals) are per thread, so every generation has a context of its own and
+//generators can run at the same time; -pmi, -cache and -checkpoint use state of the process and
+//cannot. Messages go to the log of gnl (lout). The result is a GnlNetlist, a read-only view of the
+//generated module itself: it takes over the module and the library cells, so nothing is copied and
+//no file is written (unless -w is given).
+//
+//  GnlGenerator generator;
+//  generator.SetFile("circuit.gnl");
+//  generator.SetOptions({"-seed", "7", "-nw"});
+//  GnlNetlist *netlist = generator.Generate();
+//  for (GnlBlock block : netlist->Blocks())
+//      for (int i = 0; i < block.NumInputs(); ++i)
+//          for (GnlPin sink : block.Input(i).Sinks())
+//              ...
+
+//a [library], [module] or [circuit] section at a time, with the keys of the gnl file format
+class GnlSpec {
+public:
+    void BeginLibrary(const string &name);
+
+    void AddGate(const string &name, int inputs, int outputs, int area = 1, double delay = 1);
+
+    void AddLatch(const string &name, int inputs, int outputs, int area = 1, double delay = 1);
+
+    void BeginModule(const string &name);
+
+    void BeginCircuit(const string &name);
+
+    //a key of the current module or circuit: libraries, distribution, size, p, q, meanT, sigmaT, meanG,
+    //sigmaG, I or O. As in a gnl file, every size starts a region and the last one is the total size
+    void Set(const string &key, const string &value);
+
+    //the specification in the gnl file format
+    const string &Text() const { return text; }
+
+private:
+    void AddCell(const char *kind, const string &name, int inputs, int outputs, int area, double delay);
+
+    string text;
+};
+
+//the handles of a netlist are pointers into the generated module; they are valid while the netlist is
+class GnlNet;
+
+class GnlPin;
+
+//a range of handles over a list of the module
+template<class Handle, class Item>
+class GnlRange {
+public:
+    class iterator {
+    public:
+        iterator(typename list<Item>::const_iterator i) : it(i) {}
+
+        Handle operator*() const { return Handle(*it); }
+
+        iterator &operator++() {
+            ++it;
+            return *this;
+        }
+
+        bool operator!=(const iterator &other) const { return it != other.it; }
+
+        bool operator==(const iterator &other) const { return it == other.it; }
+
+    private:
+        typename list<Item>::const_iterator it;
+    };
+
+    GnlRange(const list<Item> &l) : items(l) {}
+
+    iterator begin() const { return items.begin(); }
+
+    iterator end() const { return items.end(); }
+
+    long size() const { return items.size(); }
+
+private:
+    const list<Item> &items;
+};
+
+class GnlBlock {
+public:
+    GnlBlock(Module::Block *b) : block(b) {}
+
+    const Librarycell *Cell() const;
+
+    int NumInputs() const;
+
+    int NumOutputs() const;
+
+    //the net on input pin i and on output pin o
+    GnlNet Input(int i) const;
+
+    GnlNet Output(int o) const;
+
+    bool operator==(const GnlBlock &other) const { return block == other.block; }
+
+    bool operator<(const GnlBlock &other) const { return block < other.block; }
+
+private:
+    Module::Block *block;
+};
+
+class GnlPin {
+public:
+    GnlPin(const Module::Terminal &t) : block(t.first), pin(t.second) {}
+
+    GnlBlock Block() const { return block; }
+
+    //the number of the input or output pin on the block
+    int Pin() const { return pin; }
+
+private:
+    GnlBlock block;
+    int pin;
+};
+
+class GnlNet {
+public:
+    typedef GnlRange<GnlPin, Module::Terminal> PinRange;
+
+    GnlNet(Module::Net *n) : net(n) {}
+
+    //whether a block drives the net; the other nets are driven by a circuit input
+    bool Driven() const;
+
+    GnlPin Source() const;
+
+    PinRange Sinks() const;
+
+    bool operator==(const GnlNet &other) const { return net == other.net; }
+
+    bool operator<(const GnlNet &other) const { return net < other.net; }
+
+private:
+    Module::Net *net;
+};
+
+class GnlNetlist {
+public:
+    typedef GnlRange<GnlBlock, Module::Block *> BlockRange;
+    typedef GnlRange<GnlNet, Module::InputNet *> InputRange;
+    typedef GnlRange<GnlNet, Module::OutputNet *> OutputRange;
+
+    ~GnlNetlist();
+
+    const string &Name() const { return name; }
+
+    int NumBlocks() const { return module->numBlocks; }
+
+    int NumInputs() const { return module->numInputs; }
+
+    int NumOutputs() const { return module->numOutputs; }
+
+    BlockRange Blocks() const { return module->blocks; }
+
+    //the nets of the circuit inputs, of the circuit outputs and the other nets driven by a block. The
+    //nets that feed an inserted flop are not in these lists; they are on the pins of their blocks
+    InputRange Inputs() const { return module->inputs; }
+
+    OutputRange Outputs() const { return module->outputs; }
+
+    OutputRange InternalNets() const { return module->internalNets; }
+
+    //the libraries of the specification, with their cells
+    const map<string, Library> &Libraries() const { return libraries; }
+
+    //the macrocell instances in each module instance
+    const map<string, list<string> > &Hierarchy() const { return hierarchy; }
+
+private:
+    GnlNetlist() : module(0), circuit(0) {}
+
+    GnlNetlist(const GnlNetlist &);
+
+    Module *module;
+    ModuleType *circuit;
+    string name;
+    map<string, Library> libraries;
+    map<string, list<string> > hierarchy;
+    friend class GnlGenerator;
+};
+
+class GnlGenerator {
+public:
+    void SetFile(const string &gnlFile);
+
+    //the specification is written to a temporary gnl file for the parser
+    void SetSpec(const GnlSpec &spec);
+
+    //options as on the command line of gnl, e.g. {"-seed", "7", "-ap"}
+    void SetOptions(const vector<string> &options) { this->options = options; }
+
+    //a consumer that gets the netlist of the circuit streamed to it while it is generated, as the file
+    //formats are (see visitor.h); the caller keeps the visitor
+    void AddVisitor(NetlistVisitor *visitor) { visitors.push_back(visitor); }
+
+    //generates the circuit; the caller owns the netlist. Throws a string on errors
+    GnlNetlist *Generate();
+
+private:
+    void Run(GnlNetlist *&netlist, string &error);
+
+    string file;
+    string specText;
+    vector<string> options;
+    vector<NetlistVisitor *> visitors;
+};
+
+#endif //{_H_Libgnl}
@@ -50,18 +50,40 @@ public:
         int inputs, outputs;
     };
 
-    static map<string, Library> libraries;
-    static Librarycell *flop;
-    static ModuleType *circuit;
-    static int progress;
-    static map<string, list<string> > hierarchy;
+    //region parameter set from outside the gnl file (see sweep.cpp)
+    struct RegionOverride {
+        RegionOverride(const string &m, int s, const string &p, double v) : module(m), size(s), parameter(p),
+                                                                            value(v), applied(0) {}
+
+        string module;
+        int size;
+        string parameter;
+        double value;
+        int applied;
+    };
+
+    static void Clear();
+
+    //all the generator state is per thread, so independent generations can run concurrently
+    static thread_local map<string, Library> libraries;
+    static thread_local Librarycell *flop;
+    static thread_local ModuleType *circuit;
+    static thread_local int progress;
+    static thread_local map<string, list<string> > hierarchy;
+    static thread_local vector<NetlistVisitor *> visitors;    //consumers of the circuit netlist (see visitor.h)
     static string version;
-    static DelayDistrib delays;
-    static vector<double> targetDelayDistrib;
-    static int moduleCounter;
-    static list<PtreeNode> treeData;
+    static thread_local DelayDistrib delays;
+    static thread_local vector<double> targetDelayDistrib;
+    static thread_local int moduleCounter;
+    static thread_local list<PtreeNode> treeData;
+    static thread_local list<RegionOverride> regionOverrides;
 };
 
+void InitializeGenerator();
+
 void ParseGnlFile();
 
+//the output file of an instance with the extension, in the -od directory or in the working directory
+string OutputFileName(const string &name, const char *extension);
+
 #endif //{_H_Gnl}
\ No newline at end of file
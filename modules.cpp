@@ -32,56 +32,87 @@
 #include "main.h"
 #include "argread.h"
 #include "debug.h"
+#include "progress.h"
+#include "statistics.h"
+#include "scheduler.h"
+#include "checkpoint.h"
+#include <algorithm>
 #include "pvtools.h"
 
 Module *ModuleType::GetInstance() {
     lout << "Generating instance of module " << name << ".\n";
-    if (Globals::circuit == this)
-        Globals::progress = numBlocks;
+    ProgressReporter progress;
+    if (Globals::circuit == this) {
+        //every combination reduces the number of modules by one
+        Globals::progress = numBlocks - 1;
+        if (argRead.showProgress)
+            progress.Start(Globals::progress);
+    }
 
     //initalize temp variables in ModuleType
     InitializeInstanceName();
-    InitializeForrest();
+    {
+        PhaseTimer timer(Statistics::initializeForrest);
+        InitializeForrest();
+    }
     rtdWritten = 0;
     datWritten = 0;
     buckets.clear();
     distributionBuckets.clear();
 
-    if (argRead.debugBits & debug::combine)
+    if (debug::On(debug::combine))
         dout << "\n*** Combinations ***\n";
 
-    BuildPartitionTree();
-    Module *module=forrest.begin()->second->BuildModule(this);
-
-    if (argRead.showProgress)
-        cout << "                                                 \r" << flush;
+    {
+        PhaseTimer timer(Statistics::buildPartitionTree);
+        BuildPartitionTree();
+        OrderPartitionTree();
+    }
+    Module *module;
+    {
+        PhaseTimer timer(Statistics::buildModule);
+        module = BuildModule();
+    }
 
     module->PostProcess(this);
-    DeletePartitionTree();
+    {
+        PhaseTimer timer(Statistics::deletePartitionTree);
+        DeletePartitionTree();
+    }
 
-    if (argRead.debugBits & debug::consistency)
+    if (debug::On(debug::consistency) && !argRead.statisticsOnly)
     module->CheckConsistency();
+
+    if (Globals::circuit == this &&
+        find(argRead.outputFormats.begin(), argRead.outputFormats.end(), string("json")) != argRead.outputFormats.end())
+        Statistics::WriteReport(InstanceName(), this, module);
     return module;
 }
 
 void ModuleType::InitializeForrest() {
     if (!forrest.empty())
         throw ("Internal error: forrest not empty");
+    int numLeaves = 0;
+    for (list<int>::iterator di = distribution.begin(); di != distribution.end(); ++di)
+        numLeaves += *di;
+    partitionTree.Reserve(numLeaves);
     list<int>::iterator di = distribution.begin();
     for (list<string>::iterator li = libraries.begin(); li != libraries.end(); ++li) {
         map<string, Library>::iterator it = Globals::libraries.find(*li);
         if (it == Globals::libraries.end())
             throw ("Internal error: unknown library");
         for (list<Cell *>::iterator ci = it->second.cells.begin(); ci != it->second.cells.end(); ++ci) {
+            Librarycell *libcell = dynamic_cast<Librarycell *>(*ci);
+            ModuleType *modType = dynamic_cast<ModuleType *>(*ci);
+            if (!libcell && !modType)
+                throw ("Internal error: cell should be libcell or macrocell");
             for (int i = 0; i < *di; ++i) {
-                Librarycell *libcell = dynamic_cast<Librarycell *>(*ci);
-                ModuleType *modType = dynamic_cast<ModuleType *>(*ci);
                 if (libcell)
-                    InsertIntoForrest(new LibrarycellNode(libcell));
-                else if (modType)
-                    InsertIntoForrest(new MacrocellNode(modType));
+                    InsertIntoForrest(partitionTree.AddLeaf(PartitionTree::librarycell, libcell, libcell->Size(), 1,
+                                                            libcell->I(), libcell->O()));
                 else
-                    throw ("Internal error: cell should be libcell or macrocell");
+                    InsertIntoForrest(partitionTree.AddLeaf(PartitionTree::macrocell, modType, modType->Size(),
+                                                            modType->NumBlocks(), -1, -1));
             }
             ++di;
         }
@@ -89,106 +120,224 @@ void ModuleType::InitializeForrest() {
 }
 
 void ModuleType::BuildPartitionTree() {
+    PartitionTree &tree = partitionTree;
     while (forrest.size() > 1) {
-        TreeNode *n1 = forrest.begin()->second;
+        int n1 = forrest.begin()->second;
         forrest.erase(forrest.begin());
+        Statistics::Memory(Statistics::forrestMemory, -forrestBytes);
 
-        LibrarycellNode *lc1 = dynamic_cast<LibrarycellNode *>(n1);
-        if (lc1 && lc1->cell->Sequential() && !argRead.combineAccordingToSize)
+        if (tree.SequentialCell(n1) && !argRead.combineAccordingToSize)
             InsertIntoForrest(n1);
         else {
-            TreeNode *n2 = forrest.begin()->second;
+            int n2 = forrest.begin()->second;
             forrest.erase(forrest.begin());
+            Statistics::Memory(Statistics::forrestMemory, -forrestBytes);
 
-            if (n2->NumBlocks() == 1 && n1->NumBlocks() > 1) {
-                //swap n1 and n2
-                TreeNode *temp = n1;
-                n1 = n2;
-                n2 = temp;
-            }
-            if (n1->NumBlocks() == 1 && n2->NumBlocks() >= 1 && (n1->NumTerminals() > GetMaxT(n2->NumBlocks()) ||
-                                                                 n2->NumBlocks() == 1 &&
-                                                                 n2->NumTerminals() > GetMaxT(1))) {
+            if (tree.numBlocks[n2] == 1 && tree.numBlocks[n1] > 1)
+                swap(n1, n2);
+            if (tree.numBlocks[n1] == 1 && tree.numBlocks[n2] >= 1 &&
+                (tree.NumTerminals(n1) > GetMaxT(tree.numBlocks[n2]) ||
+                 tree.numBlocks[n2] == 1 && tree.NumTerminals(n2) > GetMaxT(1))) {
+                InsertIntoForrest(n1);
+                InsertIntoForrest(n2);
+            } else if (tree.SequentialCell(n2) && tree.numBlocks[n1] <= argRead.minSeqBlocks) {
                 InsertIntoForrest(n1);
                 InsertIntoForrest(n2);
             } else {
-                LibrarycellNode *lc2 = dynamic_cast<LibrarycellNode *>(n2);
-                if (lc2 && lc2->cell->Sequential() && n1->NumBlocks() <= argRead.minSeqBlocks) {
-                    InsertIntoForrest(n1);
-                    InsertIntoForrest(n2);
-                } else {
-                    InsertIntoForrest(new CompoundNode(n1, n2));
-                }
+                InsertIntoForrest(tree.AddCompound(n1, n2));
+            }
+        }
+    }
+}
+
+template<class T>
+static void Permute(vector<T> &v, const vector<int> &order) {
+    vector<T> permuted;
+    permuted.reserve(order.size());
+    for (vector<int>::const_iterator oi = order.begin(); oi != order.end(); ++oi)
+        permuted.push_back(v[*oi]);
+    v.swap(permuted);
+}
+
+void ModuleType::OrderPartitionTree() {
+    if (forrest.size() != 1)
+        throw ("Internal error: forrest is not a tree");
+    PartitionTree &tree = partitionTree;
+    vector<int> order, stack(1, forrest.begin()->second);
+    order.reserve(tree.Size());
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        order.push_back(node);
+        if (tree.kinds[node] == PartitionTree::compound) {
+            stack.push_back(tree.right[node]);
+            stack.push_back(tree.left[node]);
+        }
+    }
+
+    vector<int> position(tree.Size());
+    for (int i = 0; i < int(order.size()); ++i)
+        position[order[i]] = i;
+    for (int node = 0; node < tree.Size(); ++node)
+        if (tree.kinds[node] == PartitionTree::compound) {
+            tree.left[node] = position[tree.left[node]];
+            tree.right[node] = position[tree.right[node]];
+        }
+    Permute(tree.kinds, order);
+    Permute(tree.left, order);
+    Permute(tree.right, order);
+    Permute(tree.area, order);
+    Permute(tree.numBlocks, order);
+    Permute(tree.numInputs, order);
+    Permute(tree.numOutputs, order);
+    tree.Charge();
+    forrest.begin()->second = 0;
+}
+
+//builds the modules bottom-up: in reverse pre-order the children of a node come before it, the right one
+//first, so the left module is on top when the node combines them
+Module *ModuleType::BuildModule() {
+    PartitionTree &tree = partitionTree;
+    vector<Module *> built;
+    int node = tree.Size() - 1;
+    if (Checkpoint::On() && Globals::circuit == this)
+        node = Checkpoint::Resume(this, built);
+    for (; node >= 0; --node) {
+        if (Checkpoint::Due(this))
+            Checkpoint::Write(this, node, built);
+        if (tree.kinds[node] == PartitionTree::librarycell)
+            built.push_back(new Module(static_cast<Librarycell *>(tree.cells[tree.left[node]])));
+        else if (tree.kinds[node] == PartitionTree::macrocell) {
+            ModuleType *macroType = static_cast<ModuleType *>(tree.cells[tree.left[node]]);
+            string macroName;
+            Module *module = MacrocellScheduler::Take(macroType, macroName);
+            if (!module) {
+                module = macroType->GetInstance();
+                macroName = macroType->InstanceName();
             }
+            Globals::hierarchy[InstanceName()].push_back(macroName);
+            tree.numInputs[node] =module->NumInputs();
+            tree.numOutputs[node] =module->NumOutputs();
+            built.push_back(module);
+        } else {
+            Module *leftModule = built.back();
+            built.pop_back();
+            Module *module=new Module(leftModule, built.back(), this);
+            tree.area[node] =module->Size();
+            tree.numBlocks[node] =module->NumBlocks();
+            tree.numInputs[node] =module->NumInputs();
+            tree.numOutputs[node] =module->NumOutputs();
+            Progress::Combined();
+            built.back() = module;
         }
     }
+    if (built.size() != 1)
+        throw ("Internal error: partition tree built more than one module");
+    return built.back();
 }
 
 void ModuleType::DeletePartitionTree() {
     if (forrest.size() != 1)
         throw ("Internal error: forrest is not a tree");
-    DeleteNode(forrest.begin()->second);
+    partitionTree.Clear();
     forrest.clear();
+    Statistics::Memory(Statistics::forrestMemory, -forrestBytes);
 }
 
-inline void ModuleType::InsertIntoForrest(TreeNode *node) {
+inline void ModuleType::InsertIntoForrest(int node) {
     int indexA = 0, indexB = 0;
     if (argRead.combineAccordingToSize)
-        indexA = node->Size();
-    multimap<IntPair, TreeNode *>::iterator f = forrest.upper_bound(IntPair(indexA, -1));
+        indexA = partitionTree.area[node];
+    multimap<IntPair, int>::iterator f = forrest.upper_bound(IntPair(indexA, -1));
     if (f != forrest.end())
         indexB = f->first.second;
-    forrest.insert(pair<IntPair, TreeNode *>(IntPair(indexA, randomNumber(indexB, INT_MAX)), node));
+    forrest.insert(pair<IntPair, int>(IntPair(indexA, randomNumber(indexB, INT_MAX)), node));
+    Statistics::Memory(Statistics::forrestMemory, forrestBytes);
 }
 
-void ModuleType::DeleteNode(TreeNode *node) {
-    CompoundNode *compoundNode = dynamic_cast<CompoundNode *>(node);
-    if (compoundNode) {
-        DeleteNode(compoundNode->left);
-        DeleteNode(compoundNode->right);
-    }
-    delete node;
+//the arrays of a tree over numLeaves leaves, which has 2 * numLeaves - 1 nodes
+void ModuleType::PartitionTree::Reserve(int numLeaves) {
+    int numNodes = max(2 * numLeaves - 1, 0);
+    kinds.reserve(numNodes);
+    left.reserve(numNodes);
+    right.reserve(numNodes);
+    area.reserve(numNodes);
+    numBlocks.reserve(numNodes);
+    numInputs.reserve(numNodes);
+    numOutputs.reserve(numNodes);
+    cells.reserve(numLeaves);
+    Charge();
 }
 
-Module *ModuleType::LibrarycellNode::BuildModule(ModuleType *modType) {
-    return new Module(cell);
+int ModuleType::PartitionTree::AddLeaf(Kind kind, Cell *cell, int cellArea, int cellBlocks, int cellInputs,
+                                       int cellOutputs) {
+    kinds.push_back(kind);
+    left.push_back(cells.size());
+    right.push_back(-1);
+    area.push_back(cellArea);
+    numBlocks.push_back(cellBlocks);
+    numInputs.push_back(cellInputs);
+    numOutputs.push_back(cellOutputs);
+    cells.push_back(cell);
+    return kinds.size() - 1;
 }
 
-Module *ModuleType::MacrocellNode::BuildModule(ModuleType *modType) {
-    Module *module=macroType->GetInstance();
-    Globals::hierarchy[modType->InstanceName()].push_back(macroType->InstanceName());
-    numInputs =module->NumInputs();
-    numOutputs =module->NumOutputs();
-    return module;
+int ModuleType::PartitionTree::AddCompound(int l, int r) {
+    int size = area[l] + area[r], blocks = numBlocks[l] + numBlocks[r];
+    kinds.push_back(compound);
+    left.push_back(l);
+    right.push_back(r);
+    area.push_back(size);
+    numBlocks.push_back(blocks);
+    numInputs.push_back(-1);
+    numOutputs.push_back(-1);
+    return kinds.size() - 1;
 }
 
-Module *ModuleType::CompoundNode::BuildModule(ModuleType *modType) {
-    Module *module=new Module(left->BuildModule(modType), right->BuildModule(modType), modType);
-    area =module->Size();
-    numBlocks =module->NumBlocks();
-    numInputs =module->NumInputs();
-    numOutputs =module->NumOutputs();
-    if (argRead.showProgress) {
-        cout << "Module count: " << Globals::progress << "                    \r" << flush;
-        --Globals::progress;
-    }
-    return module;
+void ModuleType::PartitionTree::Clear() {
+    vector<Kind>().swap(kinds);
+    vector<int>().swap(left);
+    vector<int>().swap(right);
+    vector<int>().swap(area);
+    vector<int>().swap(numBlocks);
+    vector<int>().swap(numInputs);
+    vector<int>().swap(numOutputs);
+    vector<Cell *>().swap(cells);
+    Charge();
+}
+
+//charges the capacity of the arrays to the tree node memory
+void ModuleType::PartitionTree::Charge() {
+    long now = long(kinds.capacity()) * nodeBytes + long(cells.capacity() * sizeof(Cell *));
+    Statistics::Memory(Statistics::treeNodeMemory, now - bytes);
+    bytes = now;
 }
 
 void Module::PostProcess(ModuleType *modType) {
-    //Write modules
+    ResolvePins();
+
+    //Write modules; the netlist formats are visitors, written together in one pass with the visitors of
+    //the circuit
     string name = modType->InstanceName();
     list<string> &formats = (Globals::circuit == modType) ? argRead.outputFormats : argRead.outputMacrocellFormats;
+    vector<NetlistVisitor *> writers;
+    string writerNames;
     for (list<string>::iterator fi = formats.begin(); fi != formats.end(); ++fi) {
-        if (*fi == "hnl")
-            WriteHnl(name, modType);
-        else if (*fi == "netD")
-            WriteNetD(name);
-        else if (*fi == "netD2")
-            WriteNetD2(name);
-        else if (*fi == "nets")
-            WriteNets(name, modType);
-        else if (*fi == "info")
+        if (argRead.statisticsOnly && (*fi == "hnl" || *fi == "netD" || *fi == "netD2" || *fi == "nets" ||
+                                       *fi == "shm" || *fi == "tree")) {
+            lout << "Statistics only: no netlist available for " << *fi << " output of " << name << ".\n";
+            continue;
+        }
+        if (*fi == "json")
+            continue;   //written by GetInstance, once the generation is complete
+        NetlistVisitor *writer = NetlistVisitor::Writer(*fi, name);
+        if (writer) {
+            writers.push_back(writer);
+            writerNames += (writerNames.empty() ? "" : "+") + *fi;
+            continue;
+        }
+        PhaseTimer timer(*fi);
+        if (*fi == "info")
             WriteInfo(name, modType);
         else if (*fi == "plot")
             WritePlots(name, modType);
@@ -201,22 +350,52 @@ void Module::PostProcess(ModuleType *modType) {
         else if (*fi == "ptree")
             WritePtree(name, modType);
     }
+    vector<NetlistVisitor *> visitors(writers);
+    if (Globals::circuit == modType && !Globals::visitors.empty()) {
+        if (argRead.statisticsOnly)
+            lout << "Statistics only: no netlist available for the visitors of " << name << ".\n";
+        else {
+            visitors.insert(visitors.end(), Globals::visitors.begin(), Globals::visitors.end());
+            writerNames += (writerNames.empty() ? "" : "+") + string("visitors");
+        }
+    }
+    try {
+        if (!visitors.empty()) {
+            PhaseTimer timer(writerNames);
+            Visit(visitors, modType);
+        }
+    }
+    catch (...) {
+        for (vector<NetlistVisitor *>::iterator wi = writers.begin(); wi != writers.end(); ++wi)
+            delete *wi;
+        throw;
+    }
+    for (vector<NetlistVisitor *>::iterator wi = writers.begin(); wi != writers.end(); ++wi)
+        delete *wi;
 
     //Check for target number of pins and g_fraction
     if (!argRead.noWarnings) {
-        int numPins = numInputs + numOutputs, I, O, targetPins;
-        modType->GetIO(area, I, O);
-        targetPins = I + O;
-        double gFrac = double(numOutputs) / numPins, targetGFrac = double(O) / targetPins;
-        if (fabs(double(numPins - targetPins)) / targetPins * 100 > argRead.maxPinError)
-            lerr << "Warning: error on number of pins exceeds " << argRead.maxPinError << "%: " << numPins << " ( "
-                 << targetPins << " ).\n";
-        if (fabs(double(gFrac - targetGFrac)) / targetGFrac * 100 > argRead.maxFracError)
-            lerr << "Warning: error on final output fraction exceeds " << argRead.maxFracError << "%: " << gFrac
-                 << " ( " << targetGFrac << ").\n";
+        PinStatistics stats = GetPinStatistics(modType);
+        if (stats.PinError() > argRead.maxPinError)
+            lerr << "Warning: error on number of pins exceeds " << argRead.maxPinError << "%: " << stats.numPins
+                 << " ( " << stats.targetPins << " ).\n";
+        if (stats.FracError() > argRead.maxFracError)
+            lerr << "Warning: error on final output fraction exceeds " << argRead.maxFracError << "%: "
+                 << stats.gFrac << " ( " << stats.targetGFrac << ").\n";
     }
 }
 
+Module::PinStatistics Module::GetPinStatistics(ModuleType *modType) {
+    PinStatistics stats;
+    int I, O;
+    modType->GetIO(area, I, O);
+    stats.numPins = numInputs + numOutputs;
+    stats.targetPins = I + O;
+    stats.gFrac = double(numOutputs) / stats.numPins;
+    stats.targetGFrac = double(O) / stats.targetPins;
+    return stats;
+}
+
 void ModuleType::InitializeInstanceName() {
     instanceName = name;
     if (Globals::circuit != this)
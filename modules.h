@@ -38,8 +38,13 @@
 #include <set>
 #include <vector>
 #include <fstream>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
 #include "libraries.h"
+#include "visitor.h"
 #include "argread.h"
+#include "statistics.h"
 
 using namespace std;
 
@@ -54,6 +59,72 @@ private:
     int next;
 };
 
+//Path delays to a set of nets, in a vector sorted on the net: a lookup is a binary search and
+//taking the maximum with another set is a single merge, done in place from the back
+template<class T>
+class DelayVector {
+public:
+    typedef pair<T *, double> Entry;
+    typedef typename vector<Entry>::const_iterator const_iterator;
+
+    const_iterator begin() const { return entries.begin(); }
+
+    const_iterator end() const { return entries.end(); }
+
+    long size() const { return entries.size(); }
+
+    double *Find(T *t) {
+        typename vector<Entry>::iterator ei = lower_bound(entries.begin(), entries.end(), Entry(t, 0), Less);
+        return ei != entries.end() && ei->first == t ? &ei->second : 0;
+    }
+
+    void Insert(T *t, double delay) {
+        entries.insert(lower_bound(entries.begin(), entries.end(), Entry(t, 0), Less), Entry(t, delay));
+    }
+
+    //empties the vector and releases its memory
+    void Clear() { vector<Entry>().swap(entries); }
+
+    bool Erase(T *t) {
+        typename vector<Entry>::iterator ei = lower_bound(entries.begin(), entries.end(), Entry(t, 0), Less);
+        if (ei == entries.end() || ei->first != t)
+            return 0;
+        entries.erase(ei);
+        return 1;
+    }
+
+    //the delay to every net of other becomes the maximum of its own and offset plus the one in other
+    void Merge(const DelayVector &other, double offset) {
+        long added = 0;
+        typename vector<Entry>::const_iterator oi = other.entries.begin();
+        for (typename vector<Entry>::const_iterator ei = entries.begin(); oi != other.entries.end(); ++oi) {
+            while (ei != entries.end() && Less(*ei, *oi))
+                ++ei;
+            if (ei == entries.end() || ei->first != oi->first)
+                ++added;
+        }
+        long n = entries.size();
+        entries.resize(n + added);
+        typename vector<Entry>::iterator to = entries.end(), ei = entries.begin() + n;
+        oi = other.entries.end();
+        while (oi != other.entries.begin()) {
+            --oi;
+            while (ei != entries.begin() && Less(*oi, *(ei - 1)))
+                *--to = *--ei;
+            if (ei != entries.begin() && (ei - 1)->first == oi->first) {
+                --ei;
+                *--to = Entry(ei->first, max(ei->second, offset + oi->second));
+            } else
+                *--to = Entry(oi->first, offset + oi->second);
+        }
+    }
+
+private:
+    static bool Less(const Entry &a, const Entry &b) { return a.first < b.first; }
+
+    vector<Entry> entries;
+};
+
 class ModuleType : public Cell {
 public:
     ModuleType() : Cell(-1, -1, -1), number(0) {}
@@ -82,20 +153,19 @@ public:
     virtual bool Sequential() { return 1; }
 
 private:
-    struct TreeNode;
-    struct CompoundNode;
-    struct LibrarycellNode;
-    struct MacrocellNode;
+    struct PartitionTree;
     struct DistribBucket;
 
     void InitializeForrest();
 
-    void InsertIntoForrest(TreeNode *);
-
-    void DeleteNode(TreeNode *);
+    void InsertIntoForrest(int node);
 
     void BuildPartitionTree();
 
+    void OrderPartitionTree();
+
+    Module *BuildModule();
+
     void DeletePartitionTree();
 
     void FillBuckets();
@@ -152,13 +222,57 @@ private:
         double newMeanG;
     };
 
+    //the partition tree in one contiguous store: a node is an index into parallel arrays. Once the tree is
+    //built, the nodes are renumbered in pre-order (a node, its left subtree, its right subtree), so the root
+    //is node 0 and the traversals are loops over the arrays that do not depend on the depth of the tree
+    struct PartitionTree {
+        enum Kind : unsigned char {
+            librarycell, macrocell, compound
+        };
+
+        PartitionTree() : bytes(0) {}
+
+        void Reserve(int numLeaves);
+
+        int AddLeaf(Kind kind, Cell *cell, int area, int numBlocks, int numInputs, int numOutputs);
+
+        int AddCompound(int l, int r);
+
+        void Clear();
+
+        int Size() { return kinds.size(); }
+
+        int NumTerminals(int node) { return numInputs[node] + numOutputs[node]; }
+
+        double GFraction(int node) { return double(numOutputs[node]) / (numInputs[node] + numOutputs[node]); }
+
+        bool SequentialCell(int node) { return kinds[node] == librarycell && cells[left[node]]->Sequential(); }
+
+        void Charge();
+
+        vector<Kind> kinds;
+        vector<int> left, right;    //the children of a compound node; for a leaf, left is its index in cells
+        vector<int> area, numBlocks, numInputs, numOutputs;
+        vector<Cell *> cells;       //the library cell or macrocell type of each leaf
+        long bytes;                 //charged to the tree node memory
+
+        static constexpr long nodeBytes = sizeof(Kind) + 6 * sizeof(int);
+    };
+
     map<int, DistribBucket> distributionBuckets;
-    multimap<IntPair, TreeNode *> forrest;
-    map<int, list<TreeNode *> > buckets;
+    multimap<IntPair, int> forrest;
+    static constexpr long forrestBytes = Statistics::MapNode(sizeof(pair<const IntPair, int>));
+    PartitionTree partitionTree;
+    map<int, list<int> > buckets;
     bool rtdWritten;
     bool datWritten;
 
     friend void ParseGnlFile();
+    friend class ResourceEstimator;
+    friend class MacrocellScheduler;
+    friend class InstanceCache;
+    friend class Checkpoint;
+    friend class GenerationServer;
 };
 
 inline bool operator<(ModuleType::IntPair &a, ModuleType::IntPair &b) {
@@ -167,6 +281,16 @@ inline bool operator<(ModuleType::IntPair &a, ModuleType::IntPair &b) {
 
 class Module {
 public:
+    //achieved versus target number of pins and output fraction
+    struct PinStatistics {
+        double PinError() { return fabs(double(numPins - targetPins)) / targetPins * 100; }
+
+        double FracError() { return fabs(gFrac - targetGFrac) / targetGFrac * 100; }
+
+        int numPins, targetPins;
+        double gFrac, targetGFrac;
+    };
+
     Module(Librarycell *cell);
 
     Module(Module *modA, Module *modB, ModuleType *modType);
@@ -175,6 +299,8 @@ public:
 
     void PostProcess(ModuleType *modType);
 
+    PinStatistics GetPinStatistics(ModuleType *modType);
+
     int Size() { return area; }
 
     int NumBlocks() { return numBlocks; }
@@ -185,25 +311,29 @@ public:
 
     int TotalPinCount();
 
+    //streams the netlist to the visitors, in a single pass (see visitor.h)
+    void Visit(const vector<NetlistVisitor *> &visitors, ModuleType *modType);
+
+    void WriteInfoHeader(ofstream &info, ModuleType *modType, string prefix = "");
+
     void CheckConsistency();
 
 private:
-    void Merge(Module *
+    //an empty module, filled by InstanceCache::Load
+    Module() : area(0), weight(0), numBlocks(0), numInputs(0), numOutputs(0), number(0) {}
 
-    module);
+    void CreateBlock(Librarycell *cell);
 
-    void WriteHnl(const string &name, ModuleType *modType);
+    void CountConnections(Module *modA, Module *modB, ModuleType *modType, int se, int si);
 
-    void WriteNetD(const string &name);
+    void StoreTreeData(Module *modA, Module *modB);
 
-    void WriteNets(const string &name, ModuleType *modType);
+    void Merge(Module *
 
-    void WriteNetD2(const string &name);
+    module);
 
     void WriteInfo(const string &name, ModuleType *modType);
 
-    void WriteInfoHeader(ofstream &info, ModuleType *modType, string prefix = "");
-
     void WritePlots(const string &name, ModuleType *modType);
 
     void WriteTree(const string &name, ModuleType *modType);
@@ -216,10 +346,21 @@ private:
     struct InputNet;
     struct OutputNet;
     typedef pair<Block *, unsigned int> Terminal;
+
+    void Discard(InputNet *inputNet);
+
+    void ResolvePins();
+
+    void VisitNet(const vector<NetlistVisitor *> &visitors, Net *net, NetlistVisitor::NetKind kind,
+                  unordered_map<Net *, int> &netIds, unordered_map<Block *, int> &blockIds, vector<bool> &visited,
+                  vector<NetlistVisitor::Pin> &sinks);
+
     list<Block *> blocks;
     list<InputNet *> inputs;
     list<OutputNet *> outputs;
     list<OutputNet *> internalNets;
+    list<InputNet *> forwardingNets;     //joined input nets that pins still point to (see Net::Join)
+    static const unsigned int forwardingRatio = 8;   //blocks per forwarding net before the pins are resolved
     int area;
     int weight;
     int numBlocks;
@@ -229,56 +370,116 @@ private:
     friend struct Net;
     friend struct InputNet;
     friend struct OutputNet;
+    friend class ResourceEstimator;
+    friend class MicroBenchmark;
+    friend class TopologicalOrder;
+    friend class PathTiming;
+    friend class InstanceCache;
+    friend class Checkpoint;
+    friend class GnlBlock;
+    friend class GnlPin;
+    friend class GnlNet;
+    friend class GnlNetlist;
 };
 
 struct Module::Block {
-    Block(Librarycell *c) : inputs(c->I()), outputs(c->O()), cell(c) {}
+    Block(Librarycell *c) : inputs(c->I()), outputs(c->O()), cell(c) {
+        Statistics::Memory(Statistics::blockMemory, Bytes());
+    }
+
+    ~Block() { Statistics::Memory(Statistics::blockMemory, -Bytes()); }
 
     void CheckConsistency();
 
-    vector<class Net *> inputs;
+    //the block, its pin vectors and its node in the blocks list of a module
+    long Bytes() {
+        return Statistics::Chunk(sizeof(Block)) + Statistics::ListNode(sizeof(Block *)) +
+               (inputs.empty() ? 0 : Statistics::Chunk(inputs.size() * sizeof(Net *))) +
+               (outputs.empty() ? 0 : Statistics::Chunk(outputs.size() * sizeof(OutputNet *)));
+    }
+
+    vector<class Net *> inputs;     //until ResolvePins, possibly a net that was joined into another one
     vector<class OutputNet *> outputs;
     Librarycell *cell;
     int moduleNumber;
+    int order;      //position in the topological order of the combinational blocks (-ap, see TopologicalOrder)
+    bool mark;
 };
 
 struct Module::Net {
 public:
+    Net(bool driven) : parent(driven ? this : 0) {}
+
+    ~Net() { Statistics::Memory(Statistics::sinkMemory, -long(sinks.size()) * sinkBytes); }
+
+    void AddSink(const Terminal &t) {
+        sinks.push_back(t);
+        Statistics::Memory(Statistics::sinkMemory, sinkBytes);
+    }
+
     void Join(InputNet *inputNet);
 
+    //the net that a pin pointing to net belongs to
+    static Net *Find(Net *net);
+
     void CheckConsistency();
 
-    void WriteNetD(ofstream &out, CounterMap &cellMap);
+    list<Terminal> sinks;
+    //an OutputNet, driven by a block
+    bool Driven() { return parent == this; }
 
-    void WriteNets(ofstream &out, CounterMap &cellMap);
+    //the net this one is joined into, if its pins were not rewritten. Output nets are never joined into
+    //another net and point to themselves, which tells them apart from input nets
+    Net *parent;
 
-    list<Terminal> sinks;
+    //a join rewrites the pins of at most this many sinks; the pins of a larger net keep pointing to it
+    static const unsigned int rewriteLimit = 8;
+
+    static constexpr long sinkBytes = Statistics::ListNode(sizeof(Terminal));
 };
 
 struct Module::InputNet : public Module::Net {
 public:
-    InputNet(double minl, double maxl) : requiredMinLength(minl), allowedMaxLength(maxl) {}
-
-    bool Join(InputNet *inputNet);
+    //the net and its node in the inputs list of a module
+    InputNet(double minl, double maxl) : Net(0), requiredMinLength(minl), allowedMaxLength(maxl) {
+        Statistics::Memory(Statistics::netMemory, Bytes());
+    }
 
-    void WriteNetD(ofstream &out, CounterMap &cellMap, int &padCounter);
+    ~InputNet();
 
-    void WriteNets(ofstream &out, CounterMap &cellMap, int &padCounter);
-
-    void WriteNetD2(ofstream &out, CounterMap &cellMap, int &padCounter);
+    bool Join(InputNet *inputNet, Module *module);
 
 public:
     double requiredMinLength;
     double allowedMaxLength;
-    map<OutputNet *, double> controllableOutputs;
+    DelayVector<OutputNet> controllableOutputs;
+
+    static constexpr long Bytes() { return Statistics::Chunk(sizeof(InputNet)) + Statistics::ListNode(sizeof(InputNet *)); }
 };
 
 struct Module::OutputNet : public Module::Net {
 public:
-    OutputNet(double l) : source(Terminal(0, 0)), maxLength(l) {}
+    //what Join would make of a connection to inputNet: connect it, or only connect it after inserting a
+    //flop (it would create a loop or a too long path), or reject it (the path would be too short)
+    enum Connection {
+        connectable, needsFlop, tooShort
+    };
+
+    //the net and its node in the outputs or internalNets list of a module
+    OutputNet(double l) : Net(1), source(Terminal(0, 0)), maxLength(l) { Statistics::Memory(Statistics::netMemory, Bytes()); }
+
+    ~OutputNet() { Statistics::Memory(Statistics::netMemory, -Bytes()); }
 
     void MakeInternal(Module *modA, Module *modB,
                       Module *modC); //TODO used to be: void OutputNet::MakeInternal(Module *modA, Module *modB, Module *modC);
+    Connection Check(InputNet *inputNet, double delayScaleFactor);
+
+    //whether connecting to inputNet would close a combinational loop
+    bool Loop(InputNet *inputNet);
+
+    //whether Join can make a connection, given whether it may insert flops in this combination
+    static bool Connectable(Connection c, bool flops) { return c == connectable || (c == needsFlop && flops); }
+
     bool
     Join(InputNet *inputNet, Module *modA, Module *modB, Module *modC, double delayScaleFactor, ModuleType *modType);
 
@@ -286,108 +487,13 @@ public:
 
     void CheckConsistency();
 
-    void WriteNetD(ofstream &out, CounterMap &cellMap, int &padCounter, bool external = 0);
-
-    void WriteNets(ofstream &out, CounterMap &cellMap, int &padCounter, bool external = 0);
-
-    void WriteNetD2(ofstream &out, CounterMap &cellMap, int &padCounter, bool external = 0);
-
 public:
     Terminal source;
     double maxLength;
-};
-
-class ModuleType::TreeNode {
-public:
-    virtual int Size() = 0;
-
-    virtual int NumBlocks() = 0;
-
-    virtual int NumInputs() = 0;
-
-    virtual int NumOutputs() = 0;
-
-    int NumTerminals() { return NumInputs() + NumOutputs(); }
-
-    double GFraction() { return double(NumOutputs()) / (NumInputs() + NumOutputs()); }
-
-    virtual Module *BuildModule(ModuleType *modType) = 0;
-
-    virtual void FillBucketsWithTree(map<int, list<TreeNode *> > &buckets);
-
-    virtual void AddRtdData(map<int, map<int, int> > &rtd) = 0;
-};
-
-class ModuleType::CompoundNode : public ModuleType::TreeNode {
-public:
-    CompoundNode(TreeNode *l, TreeNode *r) : left(l), right(r), area(l->Size() + r->Size()),
-                                             numBlocks(l->NumBlocks() + r->NumBlocks()), numInputs(-1),
-                                             numOutputs(-1) {}
-
-    virtual int Size() { return area; }
-
-    virtual int NumBlocks() { return numBlocks; }
-
-    virtual int NumInputs() { return numInputs; }
-
-    virtual int NumOutputs() { return numOutputs; }
-
-    virtual Module *BuildModule(ModuleType *modType);
-
-    virtual void FillBucketsWithTree(map<int, list<TreeNode *> > &buckets);
-
-    virtual void AddRtdData(map<int, map<int, int> > &rtd);
-
-private:
-    TreeNode *left, *right;
-    int area;
-    int numBlocks;
-    int numInputs;
-    int numOutputs;
-
-    friend void ModuleType::DeleteNode(TreeNode *);
-};
-
-class ModuleType::LibrarycellNode : public ModuleType::TreeNode {
-public:
-    LibrarycellNode(Librarycell *c) : cell(c) {}
-
-    virtual int Size() { return cell->Size(); }
-
-    virtual int NumBlocks() { return 1; }
-
-    virtual int NumInputs() { return cell->I(); }
-
-    virtual int NumOutputs() { return cell->O(); }
-
-    virtual Module *BuildModule(ModuleType *modType);
-
-    virtual void AddRtdData(map<int, map<int, int> > &rtd) { ++(rtd[1][cell->T()]); }
 
-    //private:
-    Librarycell *cell;
-};
-
-class ModuleType::MacrocellNode : public ModuleType::TreeNode {
-public:
-    MacrocellNode(ModuleType *m) : macroType(m) {}
-
-    virtual int Size() { return macroType->Size(); }
-
-    virtual int NumBlocks() { return macroType->NumBlocks(); }
-
-    virtual int NumInputs() { return numInputs; }
-
-    virtual int NumOutputs() { return numOutputs; }
-
-    virtual Module *BuildModule(ModuleType *modType);
-
-    virtual void AddRtdData(map<int, map<int, int> > &rtd) { ++(rtd[macroType->NumBlocks()][numInputs + numOutputs]); }
-
-private:
-    ModuleType *macroType;
-    int numInputs;
-    int numOutputs;
+    static constexpr long Bytes() {
+        return Statistics::Chunk(sizeof(OutputNet)) + Statistics::ListNode(sizeof(OutputNet *));
+    }
 };
 
 #endif //{_H_Modules}
\ No newline at end of file
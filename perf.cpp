@@ -0,0 +1,137 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "perf.h"
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+const char *PerfCounters::names[numEvents] = {"cycles", "instructions", "l1dMisses", "llcMisses", "branchMisses"};
+
+//the counter group of a thread, closed when the thread ends
+static thread_local struct CounterGroup {
+    CounterGroup() : opened(0), leader(-1), numCounters(0) {
+        for (int e = 0; e < PerfCounters::numEvents; ++e)
+            fds[e] = slot[e] = -1;
+    }
+
+    ~CounterGroup() {
+        for (int e = 0; e < PerfCounters::numEvents; ++e)
+            if (fds[e] >= 0)
+                close(fds[e]);
+    }
+
+    bool opened;
+    int leader;
+    int fds[PerfCounters::numEvents];
+    int slot[PerfCounters::numEvents];  //position of the event in the group read, -1 if not counted
+    int numCounters;
+    string error;
+} group;
+
+static int OpenEvent(unsigned int type, unsigned long long config, int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = groupFd < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    //this thread, on any cpu
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+bool PerfCounters::Open(string &error) {
+    if (!group.opened) {
+        group.opened = 1;
+        static const unsigned int types[numEvents] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+                                                      PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+        static const unsigned long long configs[numEvents] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int e = 0; e < numEvents; ++e) {
+            int fd = OpenEvent(types[e], configs[e], group.leader);
+            if (fd < 0) {
+                if (group.error.empty())
+                    group.error = string(names[e]) + ": " + strerror(errno);
+                continue;
+            }
+            if (group.leader < 0)
+                group.leader = fd;
+            group.fds[e] = fd;
+            group.slot[e] = group.numCounters++;
+        }
+        if (group.leader >= 0 && ioctl(group.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP)) {
+            group.error = string("enable: ") + strerror(errno);
+            group.numCounters = 0;
+        }
+    }
+    error = group.error;
+    return group.numCounters > 0;
+}
+
+bool PerfCounters::On() {
+    return group.numCounters > 0;
+}
+
+bool PerfCounters::Available(int e) {
+    return group.numCounters > 0 && group.slot[e] >= 0;
+}
+
+void PerfCounters::Read(Values &v) {
+    v.Clear();
+    if (!group.numCounters)
+        return;
+    //nr, time enabled, time running, a value per counter
+    unsigned long long data[3 + numEvents];
+    if (read(group.leader, data, sizeof(data)) < ssize_t((3 + group.numCounters) * sizeof(data[0])) || !data[2])
+        return;
+    double scale = double(data[1]) / data[2];
+    for (int e = 0; e < numEvents; ++e)
+        if (group.slot[e] >= 0)
+            v.value[e] = data[3 + group.slot[e]] * scale;
+}
+
+void PerfCounters::Values::Clear() {
+    for (int e = 0; e < numEvents; ++e)
+        value[e] = 0;
+}
+
+void PerfCounters::Values::Add(const Values &end, const Values &start) {
+    for (int e = 0; e < numEvents; ++e)
+        value[e] += end.value[e] - start.value[e];
+}
@@ -0,0 +1,77 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Perf
+#define _H_Perf
+
+#include <string>
+
+using namespace std;
+
+//Hardware performance counters of the calling thread (-perf), read with perf_event_open. The events
+//are opened as one group, so they are counted over the same intervals; when the PMU multiplexes the
+//group, the values are scaled by the fraction of the time it was counting. Events the machine does
+//not support are left out; when no counters can be opened at all, Open fails and the caller
+//continues without them.
+class PerfCounters {
+public:
+    enum Event {
+        cycles, instructions, l1dMisses, llcMisses, branchMisses, numEvents
+    };
+
+    struct Values {
+        Values() { Clear(); }
+
+        void Clear();
+
+        void Add(const Values &end, const Values &start);
+
+        double value[numEvents];
+    };
+
+    //opens the counters of this thread once; returns 0 (and the reason in error) if unavailable
+    static bool Open(string &error);
+
+    static bool On();
+
+    //current (scaled) counts
+    static void Read(Values &v);
+
+    //1 if the event is counted on this machine
+    static bool Available(int e);
+
+    static const char *Name(int e) { return names[e]; }
+
+private:
+    static const char *names[numEvents];
+};
+
+#endif //{_H_Perf}
@@ -0,0 +1,108 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "progress.h"
+#include "pvtools.h"
+#include <unistd.h>
+#include <cstdio>
+
+atomic<long> Progress::combines(0);
+atomic<long> Progress::blocks(0);
+
+//resident set size in bytes, from /proc/self/statm (0 when not available)
+long Progress::ResidentSetSize() {
+    long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (!statm)
+        return 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(statm);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+void ProgressReporter::Start(long totalCombines) {
+    total = totalCombines;
+    startCombines = Progress::combines.load();
+    startBlocks = Progress::blocks.load();
+    memory = Statistics::LiveMemory();
+    reporter = thread(&ProgressReporter::Run, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+    if (!reporter.joinable())
+        return;
+    {
+        lock_guard<mutex> guard(lock);
+        stop = 1;
+    }
+    wakeUp.notify_one();
+    reporter.join();
+    cout << string(110, ' ') << "\r" << flush;
+}
+
+void ProgressReporter::Run() {
+    chrono::steady_clock::time_point last = chrono::steady_clock::now();
+    long lastCombines = startCombines;
+    double rate = 0;
+    unique_lock<mutex> guard(lock);
+    while (!wakeUp.wait_for(guard, chrono::milliseconds(250), [this] { return stop; })) {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        long done = Progress::combines.load(memory_order_relaxed);
+        double interval = chrono::duration<double>(now - last).count();
+        //smooth the rate over the last few seconds
+        double current = (done - lastCombines) / interval;
+        rate = rate ? 0.8 * rate + 0.2 * current : current;
+        last = now;
+        lastCombines = done;
+        Show(rate);
+    }
+}
+
+void ProgressReporter::Show(double rate) {
+    long done = Progress::combines.load(memory_order_relaxed) - startCombines;
+    long blocks = Progress::blocks.load(memory_order_relaxed) - startBlocks;
+    string eta = "--:--";
+    if (rate > 0 && done < total) {
+        long left = long((total - done) / rate);
+        eta = stringPrintf("%ld:%02ld:%02ld", left / 3600, left / 60 % 60, left % 60);
+    }
+    int largest = 0;
+    for (int s = 1; s < Statistics::numStructures; ++s)
+        if (memory[s].load(memory_order_relaxed) > memory[largest].load(memory_order_relaxed))
+            largest = s;
+    long tracked = memory[Statistics::numStructures].load(memory_order_relaxed);
+    cout << stringPrintf("Combinations: %ld/%ld (%.0f%%)  %.0f/s  blocks: %ld  memory: %.1f MB (%s %.0f%%)  ETA %s  \r",
+                         done, total, total ? 100.0 * done / total : 100.0, rate, blocks,
+                         Progress::ResidentSetSize() / 1048576.0, Statistics::StructureName(largest),
+                         tracked > 0 ? 100.0 * memory[largest].load(memory_order_relaxed) / tracked : 0.0,
+                         eta.c_str()) << flush;
+}
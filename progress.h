@@ -0,0 +1,85 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Progress
+#define _H_Progress
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "statistics.h"
+
+using namespace std;
+
+//Progress report (-sp). The generator only bumps the counters below; a reporter thread samples them
+//a few times per second and shows combinations/s, blocks, memory use (with the largest structure
+//of the generating thread, see Statistics) and the estimated time left.
+class Progress {
+public:
+    static void Combined() { combines.fetch_add(1, memory_order_relaxed); }
+
+    static void BlockCreated() { blocks.fetch_add(1, memory_order_relaxed); }
+
+    static long ResidentSetSize();
+
+private:
+    static atomic<long> combines;
+    static atomic<long> blocks;
+
+    friend class ProgressReporter;
+};
+
+//Shows the progress while it exists (once Start has been called)
+class ProgressReporter {
+public:
+    ProgressReporter() : stop(0), memory(0) {}
+
+    ~ProgressReporter();
+
+    void Start(long totalCombines);
+
+private:
+    void Run();
+
+    void Show(double rate);
+
+    long total;
+    long startCombines, startBlocks;
+    mutex lock;
+    condition_variable wakeUp;
+    bool stop;
+    const atomic<long> *memory;  //live bytes per structure of the generating thread
+    thread reporter;
+};
+
+#endif //{_H_Progress}
@@ -43,6 +43,9 @@
 #include <cmath>
 #include <iomanip>
 #include <strings.h>
+#include <cstring>
+#include <thread>
+#include <condition_variable>
 
 
 Log lerr(1);
@@ -50,11 +53,66 @@ Log lout(0);
 Log dout(0);
 TempDir tempdir;
 
-Log::Log(bool isError) : dest(std), filePtr(0) {
+//Background thread that flushes the lines that are still in the stream buffers of lout and dout.
+//It is started with the first buffered line and stopped before the logs are destroyed.
+class LogFlusher {
+public:
+    LogFlusher() : stop(0) {}
+
+    ~LogFlusher() {
+        if (flusher.joinable()) {
+            {
+                lock_guard<mutex> guard(lock);
+                stop = 1;
+            }
+            wakeUp.notify_one();
+            flusher.join();
+        }
+    }
+
+    void Start() {
+        call_once(started, [this] { flusher = thread(&LogFlusher::Run, this); });
+    }
+
+private:
+    void Run() {
+        unique_lock<mutex> guard(lock);
+        while (!wakeUp.wait_for(guard, chrono::milliseconds(500), [this] { return stop; })) {
+            guard.unlock();
+            lout.Flush();
+            dout.Flush();
+            guard.lock();
+        }
+    }
+
+    mutex lock;
+    condition_variable wakeUp;
+    bool stop;
+    once_flag started;
+    thread flusher;
+};
+
+static LogFlusher logFlusher;
+
+//pending (incomplete) lines of the current thread, written out when the thread ends
+struct LogBuffers {
+    ~LogBuffers() {
+        for (map<Log *, ostringstream>::iterator bi = buffers.begin(); bi != buffers.end(); ++bi)
+            if (bi->second.tellp() > 0)
+                bi->first->Commit(bi->second, 1);
+    }
+
+    map<Log *, ostringstream> buffers;
+};
+
+static thread_local LogBuffers logBuffers;
+
+Log::Log(bool e) : dest(std), isError(e), filePtr(0), unflushed(0), flushInterval(chrono::seconds(1)) {
     stdPtr = isError ? &cerr : &cout;
 }
 
 Log::~Log() {
+    Flush();
     delete filePtr;
 }
 
@@ -77,6 +135,7 @@ void Log::SetLogFileAndVerbosity(string &fileName, const char *defaultFile, bool
 }
 
 void Log::SetLogFile(const char *name, Destination d, ios::openmode m) {
+    lock_guard<mutex> guard(lock);
     //remove previous filePtr
     delete filePtr;
     filePtr = 0;
@@ -95,19 +154,87 @@ void Log::SetDestination(Destination d) {
     dest = d;
 }
 
-Log &Log::operator<<(const char *a) {
+void Log::SetFlushInterval(double seconds) {
+    lock_guard<mutex> guard(lock);
+    flushInterval = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+}
+
+void Log::Flush() {
+    lock_guard<mutex> guard(lock);
+    if (unflushed)
+        FlushStreams();
+}
+
+ostringstream &Log::Buffer() {
+    return logBuffers.buffers[this];
+}
+
+void Log::Commit(ostringstream &buffer, bool flushNow) {
+    string text = buffer.str();
+    buffer.str("");
+    //errors may share the log file with lout: write out what lout has buffered first
+    if (isError)
+        lout.Flush();
+    lock_guard<mutex> guard(lock);
     if (dest == std || dest == both)
-        (*stdPtr) << a << flush;
+        (*stdPtr) << text;
     if (filePtr && (dest == file || dest == both))
-        (*filePtr) << a << flush;
-    return *this;
+        (*filePtr) << text;
+    unflushed = 1;
+    if (flushNow || isError || chrono::steady_clock::now() - lastFlush >= flushInterval)
+        FlushStreams();
+    else
+        logFlusher.Start();
 }
 
-Log &Log::operator<<(ostream &(*f)(ostream &a)) {
+//called with the lock held
+void Log::FlushStreams() {
     if (dest == std || dest == both)
-        (*stdPtr) << f << flush;
+        stdPtr->flush();
     if (filePtr && (dest == file || dest == both))
-        (*filePtr) << f << flush;
+        filePtr->flush();
+    unflushed = 0;
+    lastFlush = chrono::steady_clock::now();
+}
+
+Log &Log::operator<<(const char *a) {
+    if (dest != none) {
+        ostringstream &buffer = Buffer();
+        buffer << a;
+        size_t length = strlen(a);
+        if (length && a[length - 1] == '\n')
+            Commit(buffer, 0);
+    }
+    return *this;
+}
+
+Log &Log::operator<<(const string &a) {
+    if (dest != none) {
+        ostringstream &buffer = Buffer();
+        buffer << a;
+        if (!a.empty() && a[a.size() - 1] == '\n')
+            Commit(buffer, 0);
+    }
+    return *this;
+}
+
+Log &Log::operator<<(char a) {
+    if (dest != none) {
+        ostringstream &buffer = Buffer();
+        buffer << a;
+        if (a == '\n')
+            Commit(buffer, 0);
+    }
+    return *this;
+}
+
+Log &Log::operator<<(ostream &(*f)(ostream &a)) {
+    if (dest != none) {
+        ostringstream &buffer = Buffer();
+        buffer << f;
+        if (f == static_cast<ostream &(*)(ostream &)>(endl) || f == static_cast<ostream &(*)(ostream &)>(flush))
+            Commit(buffer, f == static_cast<ostream &(*)(ostream &)>(flush));
+    }
     return *this;
 }
 
@@ -171,12 +298,88 @@ ostream &operator<<(ostream &s, const TempDir &t) {
     return s;
 }
 
+//random generator state of the calling thread: the same additive feedback generator as rand(),
+//so a thread seeded with randomSeed(s) draws the same sequence as a process seeded with srand(s)
+static thread_local struct RandomState {
+    random_data data;
+    char state[128];
+    bool seeded;
+    bool haveGaussian;
+    double nextGaussian;
+} randomState;
+
+void randomSeed(unsigned int seed) {
+    memset(&randomState, 0, sizeof(randomState));
+    initstate_r(seed, randomState.state, sizeof(randomState.state), &randomState.data);
+    randomState.seeded = 1;
+}
+
+//the pointers of random_data point into the state, so they are saved as offsets
+struct SavedRandomState {
+    char state[128];
+    long start, front, rear, end;
+    int type, degree, separation;
+    bool seeded;
+    bool haveGaussian;
+    double nextGaussian;
+};
+
+string randomSaveState() {
+    SavedRandomState saved;
+    memset(&saved, 0, sizeof(saved));
+    int32_t *base = (int32_t *) randomState.state;
+    memcpy(saved.state, randomState.state, sizeof(saved.state));
+    if (randomState.seeded) {
+        saved.start = randomState.data.state - base;
+        saved.front = randomState.data.fptr - base;
+        saved.rear = randomState.data.rptr - base;
+        saved.end = randomState.data.end_ptr - base;
+        saved.type = randomState.data.rand_type;
+        saved.degree = randomState.data.rand_deg;
+        saved.separation = randomState.data.rand_sep;
+    }
+    saved.seeded = randomState.seeded;
+    saved.haveGaussian = randomState.haveGaussian;
+    saved.nextGaussian = randomState.nextGaussian;
+    return string((const char *) &saved, sizeof(saved));
+}
+
+void randomRestoreState(const string &state) {
+    SavedRandomState saved;
+    if (state.size() != sizeof(saved))
+        throw ("Internal error: wrong random generator state");
+    memcpy(&saved, state.data(), sizeof(saved));
+    memset(&randomState, 0, sizeof(randomState));
+    int32_t *base = (int32_t *) randomState.state;
+    memcpy(randomState.state, saved.state, sizeof(saved.state));
+    if (saved.seeded) {
+        randomState.data.fptr = base + saved.front;
+        randomState.data.rptr = base + saved.rear;
+        randomState.data.end_ptr = base + saved.end;
+        randomState.data.state = base + saved.start;
+        randomState.data.rand_type = saved.type;
+        randomState.data.rand_deg = saved.degree;
+        randomState.data.rand_sep = saved.separation;
+    }
+    randomState.seeded = saved.seeded;
+    randomState.haveGaussian = saved.haveGaussian;
+    randomState.nextGaussian = saved.nextGaussian;
+}
+
+static inline int randomInt() {
+    if (!randomState.seeded)
+        randomSeed(1);
+    int32_t r;
+    random_r(&randomState.data, &r);
+    return r;
+}
+
 int randomNumber(int mod) {
-    return int(1.0 * mod * rand() / (RAND_MAX + 1.0));
+    return int(1.0 * mod * randomInt() / (RAND_MAX + 1.0));
 }
 
 int randomNumber(int min, int max) {
-    return int(1.0 * (max - min) * rand() / (RAND_MAX + 1.0)) + min;
+    return int(1.0 * (max - min) * randomInt() / (RAND_MAX + 1.0)) + min;
 }
 
 string stringPrintf(const char *format ...) {
@@ -357,7 +560,7 @@ int LineParser::LineNumber() {
 }
 
 double uniform() {
-    return double(rand()) / (RAND_MAX + 1.0);
+    return double(randomInt()) / (RAND_MAX + 1.0);
 }
 
 double uniform(double mmin, double mmax) {
@@ -367,11 +570,9 @@ double uniform(double mmin, double mmax) {
 double gaussian() {
     //polar form of the Box-Muller transformation -- http://www.taygeta.com/random/gaussian.html
     double x1, x2, w, y1;
-    static double y2;
-    static bool use_last = 0;
-    if (use_last) {
-        use_last = 0;
-        return y2;
+    if (randomState.haveGaussian) {
+        randomState.haveGaussian = 0;
+        return randomState.nextGaussian;
     }
     do {
         x1 = 2.0 * uniform() - 1.0;
@@ -380,8 +581,8 @@ double gaussian() {
     } while (w >= 1.0);
     w = sqrt((-2.0 * log(w)) / w);
     y1 = x1 * w;
-    y2 = x2 * w;
-    use_last = 1;
+    randomState.nextGaussian = x2 * w;
+    randomState.haveGaussian = 1;
     return y1;
 }
 
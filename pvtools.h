@@ -38,6 +38,8 @@
 //      dout << "debug data" << int << "\n"; -> schrijft log info naar stdout en/of file.
 //      lout.SetLogFile("naam",destination); -> voert automatisch lout.SetDestination(destination) uit.
 //      lout.SetDestination(destination); -> std, file of both
+//      lout.SetFlushInterval(seconds); -> tekst wordt per thread gebufferd en per lijn weggeschreven;
+//          de streams worden hoogstens om de seconds seconden geflusht (lerr: altijd onmiddellijk)
 //
 // * temp tools: global class TempDir tempdir;
 //      tempdir.MakeDir(); -> directory met naam _tmp#### aanmaken
@@ -60,7 +62,9 @@
 //      int randomNumber(int min, int max) -> returns random number between min and max-1.
 //      list<T>::iterator randomElementFromList(list<T> &l) -> returns random element from list, or end() when list is empty
 //      void randomizeList(list<T> &l); -> randominze the order of a list
-//      void srand(unsigned int seed) -> seeds the above random generator functions
+//      void randomSeed(unsigned int seed) -> seeds the above random generator functions (per thread)
+//      string randomSaveState() -> the state of the random generator of this thread, as raw bytes
+//      void randomRestoreState(const string &state) -> continues the sequence of a saved state
 //      double uniform() -> returns a uniform random number between 0 and 1
 //      double uniform(double mmin, double mmax) -> returns a uniform random number between mmin and mmax
 //      double gaussian() -> returns a gaussian random number with mean 0 and standard deviation 1
@@ -91,6 +95,9 @@
 #include <vector>
 #include <map>
 #include <list>
+#include <mutex>
+#include <sstream>
+#include <chrono>
 
 #ifdef __hpux
 #include "/usr/include/regex.h" //for hpux
@@ -118,17 +125,39 @@ public:
 
     void SetDestination(Destination d);
 
+    void SetFlushInterval(double seconds);
+
+    void Flush();
+
     Log &operator<<(const char *a);
 
+    Log &operator<<(const string &a);
+
+    Log &operator<<(char a);
+
     Log &operator<<(ostream &(*f)(ostream &a));
 
     template<class T>
     Log &operator<<(const T &a);
 
 private:
+    //text is collected in a buffer per thread and written out a line at a time
+    ostringstream &Buffer();
+
+    void Commit(ostringstream &buffer, bool flushNow);
+
+    void FlushStreams();
+
+    friend struct LogBuffers;
+
+    mutex lock;
     Destination dest;
+    bool isError;
     ostream *stdPtr;
     ofstream *filePtr;
+    bool unflushed;
+    chrono::steady_clock::duration flushInterval;
+    chrono::steady_clock::time_point lastFlush;
 };
 
 ostream &time(ostream &s);
@@ -154,10 +183,8 @@ ostream &operator<<(ostream &s, const TempDir &t);
 
 template<class T>
 Log &Log::operator<<(const T &a) {
-    if (dest == std || dest == both)
-        (*stdPtr) << a << flush;
-    if (filePtr && (dest == file || dest == both))
-        (*filePtr) << a << flush;
+    if (dest != none)
+        Buffer() << a;
     return *this;
 }
 
@@ -165,6 +192,12 @@ int randomNumber(int mod);
 
 int randomNumber(int min, int max);
 
+void randomSeed(unsigned int seed);
+
+string randomSaveState();
+
+void randomRestoreState(const string &state);
+
 extern Log lerr;
 extern Log lout;
 extern Log dout;
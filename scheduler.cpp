@@ -0,0 +1,371 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "scheduler.h"
+#include "main.h"
+#include "topology.h"
+#include "cache.h"
+#include "pvtools.h"
+#include <thread>
+#include <algorithm>
+
+int MacrocellScheduler::argc;
+char **MacrocellScheduler::argv;
+map<string, Library> *MacrocellScheduler::libraries;
+Librarycell *MacrocellScheduler::flop;
+ModuleType *MacrocellScheduler::circuit;
+list<string> MacrocellScheduler::outputFormats;
+list<string> MacrocellScheduler::outputMacrocellFormats;
+map<ModuleType *, MacrocellScheduler::TypeInfo> MacrocellScheduler::types;
+atomic<int> MacrocellScheduler::next;
+atomic<bool> MacrocellScheduler::failed;
+mutex MacrocellScheduler::lock;
+string MacrocellScheduler::error;
+map<string, list<string> > MacrocellScheduler::hierarchy;
+thread_local map<ModuleType *, int> MacrocellScheduler::cursors;
+
+void MacrocellScheduler::Run(int c, char *v[]) {
+    list<string> &formats = argRead.outputFormats, &macroFormats = argRead.outputMacrocellFormats;
+    if (!argRead.traceFile.empty() || find(formats.begin(), formats.end(), "tree") != formats.end() ||
+        find(formats.begin(), formats.end(), "ptree") != formats.end() ||
+        find(macroFormats.begin(), macroFormats.end(), "tree") != macroFormats.end() ||
+        find(macroFormats.begin(), macroFormats.end(), "ptree") != macroFormats.end()) {
+        lout << "The tree and ptree formats and the trace number the modules in the order they are generated: "
+                "macrocell instances are not pre-generated.\n";
+        return;
+    }
+    argc = c;
+    argv = v;
+    libraries = &Globals::libraries;
+    flop = Globals::flop;
+    circuit = Globals::circuit;
+    outputFormats = formats;
+    outputMacrocellFormats = macroFormats;
+    Plan();
+
+    int numThreads = argRead.numThreads ? argRead.numThreads : int(thread::hardware_concurrency());
+    vector<ModuleType *> order;
+    for (map<ModuleType *, TypeInfo>::iterator ti = types.begin(); ti != types.end(); ++ti)
+        order.push_back(ti->first);
+    sort(order.begin(), order.end(), LevelOrder);
+    for (int level = 0; level < types[circuit].level; ++level) {
+        vector<Job> jobs;
+        int numCached = 0;
+        for (vector<ModuleType *>::reverse_iterator oi = order.rbegin(); oi != order.rend(); ++oi)
+            if (types[*oi].level == level)
+                for (int i = 0; i < types[*oi].count; ++i)
+                    if (types[*oi].instances[i].needed) {
+                        Job job = {*oi, i};
+                        jobs.push_back(job);
+                        numCached += types[*oi].instances[i].cached;
+                    }
+        if (jobs.empty())
+            continue;
+        int n = max(1, min(numThreads, int(jobs.size())));
+        lout << "Pre-generating " << jobs.size() << " macrocell instances of level " << level;
+        if (numCached)
+            lout << " (" << numCached << " from the cache)";
+        lout << " on " << n << " threads.\n";
+        next = 0;
+        failed = 0;
+        vector<thread> workers;
+        for (int t = 0; t < n; ++t)
+            workers.push_back(thread(Worker, ref(jobs)));
+        for (vector<thread>::iterator wi = workers.begin(); wi != workers.end(); ++wi)
+            wi->join();
+        if (failed)
+            throw (error);
+    }
+
+    for (map<string, list<string> >::iterator hi = hierarchy.begin(); hi != hierarchy.end(); ++hi)
+        Globals::hierarchy[hi->first].splice(Globals::hierarchy[hi->first].end(), hi->second);
+    hierarchy.clear();
+    Reserve(circuit, 0);
+}
+
+Module *MacrocellScheduler::Take(ModuleType *macroType, string &instanceName) {
+    map<ModuleType *, int>::iterator ci = cursors.find(macroType);
+    if (ci == cursors.end())
+        return 0;
+    vector<Instance> &instances = types.find(macroType)->second.instances;
+    if (ci->second >= int(instances.size()) || !instances[ci->second].module)
+        throw ("Internal error: macrocell instance not pre-generated");
+    Instance &instance = instances[ci->second++];
+    Module *module = instance.module;
+    instance.module = 0;
+    instanceName = instance.name;
+    for (int s = 0; s < moduleStructures; ++s)
+        Statistics::Memory(Statistics::Structure(s), instance.memory[s]);
+    if (TopologicalOrder::On())
+        TopologicalOrder::Adopt(module);
+    return module;
+}
+
+void MacrocellScheduler::Clear() {
+    cursors.clear();
+    for (map<ModuleType *, TypeInfo>::iterator ti = types.begin(); ti != types.end(); ++ti)
+        for (vector<Instance>::iterator ii = ti->second.instances.begin(); ii != ti->second.instances.end(); ++ii)
+            if (ii->module) {
+                for (int s = 0; s < moduleStructures; ++s)
+                    Statistics::Memory(Statistics::Structure(s), ii->memory[s]);
+                delete ii->module;
+            }
+    types.clear();
+    hierarchy.clear();
+}
+
+//the module types in the hierarchy below the circuit, how many instances of each are needed and which
+//ones every parent instance takes
+void MacrocellScheduler::Plan() {
+    types.clear();
+    types[circuit].count = 1;
+    vector<ModuleType *> stack(1, circuit);
+    while (!stack.empty()) {
+        ModuleType *modType = stack.back();
+        stack.pop_back();
+        TypeInfo &info = types[modType];
+        list<int>::iterator di = modType->distribution.begin();
+        for (list<string>::iterator li = modType->libraries.begin(); li != modType->libraries.end(); ++li) {
+            list<Cell *> &cells = (*libraries)[*li].cells;
+            for (list<Cell *>::iterator ci = cells.begin(); ci != cells.end(); ++ci, ++di) {
+                ModuleType *child = dynamic_cast<ModuleType *>(*ci);
+                if (!child || *di <= 0)
+                    continue;
+                info.children[child] += *di;
+                if (types.find(child) == types.end()) {
+                    types[child];
+                    stack.push_back(child);
+                }
+            }
+        }
+    }
+
+    //a module type can only contain the ones defined before it, so this settles
+    for (bool changed = 1; changed;) {
+        changed = 0;
+        for (map<ModuleType *, TypeInfo>::iterator ti = types.begin(); ti != types.end(); ++ti)
+            for (map<ModuleType *, int>::iterator ci = ti->second.children.begin();
+                 ci != ti->second.children.end(); ++ci)
+                if (ti->second.level <= types[ci->first].level) {
+                    ti->second.level = types[ci->first].level + 1;
+                    changed = 1;
+                }
+    }
+
+    //parents before their children, so the count of a type is complete before it hands out its instances
+    vector<ModuleType *> order;
+    for (map<ModuleType *, TypeInfo>::iterator ti = types.begin(); ti != types.end(); ++ti)
+        order.push_back(ti->first);
+    sort(order.begin(), order.end(), LevelOrder);
+    for (vector<ModuleType *>::iterator oi = order.begin(); oi != order.end(); ++oi) {
+        TypeInfo &info = types[*oi];
+        if (*oi != circuit)
+            info.instances.resize(info.count);
+        for (map<ModuleType *, int>::iterator ci = info.children.begin(); ci != info.children.end(); ++ci) {
+            TypeInfo &child = types[ci->first];
+            info.bases[ci->first] = child.count;
+            child.count += info.count * ci->second;
+        }
+    }
+
+    if (InstanceCache::On()) {
+        InstanceCache::Begin();
+        //children before their parents: the key of an instance holds the keys of the instances it takes
+        for (vector<ModuleType *>::reverse_iterator oi = order.rbegin(); oi != order.rend(); ++oi) {
+            if (*oi == circuit)
+                continue;
+            TypeInfo &info = types[*oi];
+            vector<ModuleType *> children = Children(info);
+            for (int i = 0; i < info.count; ++i) {
+                vector<string> childKeys;
+                for (vector<ModuleType *>::iterator ci = children.begin(); ci != children.end(); ++ci) {
+                    vector<Instance> &instances = types[*ci].instances;
+                    int first = info.bases[*ci] + i * info.children[*ci];
+                    for (int k = first; k < first + info.children[*ci]; ++k)
+                        childKeys.push_back(instances[k].key);
+                }
+                info.instances[i].key = InstanceCache::Key(*oi, Seed(*oi, i), childKeys);
+            }
+        }
+    }
+
+    //the instances below one that is loaded from the cache are not needed. The instances of the
+    //macrocell formats are written while they are generated, so they are not loaded
+    bool load = InstanceCache::On() && outputMacrocellFormats.empty();
+    for (vector<ModuleType *>::iterator oi = order.begin(); oi != order.end(); ++oi) {
+        TypeInfo &info = types[*oi];
+        for (int i = 0; i < info.count; ++i) {
+            if (*oi != circuit) {
+                Instance &instance = info.instances[i];
+                if (!instance.needed)
+                    continue;
+                instance.cached = load && InstanceCache::Exists(instance.key);
+                if (instance.cached)
+                    continue;
+            }
+            for (map<ModuleType *, int>::iterator ci = info.children.begin(); ci != info.children.end(); ++ci) {
+                int first = info.bases[ci->first] + i * ci->second;
+                for (int k = first; k < first + ci->second; ++k)
+                    types[ci->first].instances[k].needed = 1;
+            }
+        }
+    }
+}
+
+//the child types of a type by name, the order of their keys in the key of an instance
+vector<ModuleType *> MacrocellScheduler::Children(TypeInfo &info) {
+    map<string, ModuleType *> byName;
+    for (map<ModuleType *, int>::iterator ci = info.children.begin(); ci != info.children.end(); ++ci)
+        byName[ci->first->Name()] = ci->first;
+    vector<ModuleType *> children;
+    for (map<string, ModuleType *>::iterator ci = byName.begin(); ci != byName.end(); ++ci)
+        children.push_back(ci->second);
+    return children;
+}
+
+//higher levels first, then by name
+bool MacrocellScheduler::LevelOrder(ModuleType *a, ModuleType *b) {
+    int levelA = types[a].level, levelB = types[b].level;
+    return levelA != levelB ? levelA > levelB : a->Name() < b->Name();
+}
+
+void MacrocellScheduler::Worker(vector<Job> &jobs) {
+    try {
+        argRead.AR_ReadArgs(argc, argv);
+        argRead.outputFormats = outputFormats;
+        argRead.outputMacrocellFormats = outputMacrocellFormats;
+        argRead.showProgress = 0;
+        InitializeGenerator();
+        Globals::libraries = *libraries;
+        Globals::flop = flop;
+        Globals::circuit = circuit;
+        for (int n = next++; n < int(jobs.size()) && !failed; n = next++)
+            Generate(jobs[n]);
+    }
+    catch (int e) {
+        lock_guard<mutex> guard(lock);
+        error = "invalid options";
+        failed = 1;
+    }
+    catch (const char *msg) {
+        lock_guard<mutex> guard(lock);
+        error = msg;
+        failed = 1;
+    }
+    catch (const string &msg) {
+        lock_guard<mutex> guard(lock);
+        error = msg;
+        failed = 1;
+    }
+    catch (...) {
+        lock_guard<mutex> guard(lock);
+        error = "Internal error: an error is thrown but not catched!";
+        failed = 1;
+    }
+
+    //the libraries are borrowed from the main thread: forget their cells before the copy goes
+    for (map<string, Library>::iterator li = Globals::libraries.begin(); li != Globals::libraries.end(); ++li)
+        li->second.cells.clear();
+    Globals::libraries.clear();
+    Globals::flop = 0;
+    Globals::circuit = 0;
+    lock_guard<mutex> guard(lock);
+    for (map<string, list<string> >::iterator hi = Globals::hierarchy.begin(); hi != Globals::hierarchy.end(); ++hi)
+        hierarchy[hi->first].splice(hierarchy[hi->first].end(), hi->second);
+    Globals::hierarchy.clear();
+}
+
+void MacrocellScheduler::Generate(Job &job) {
+    Instance &instance = types.find(job.modType)->second.instances[job.instance];
+    const atomic<long> *live = Statistics::LiveMemory();
+    for (int s = 0; s < moduleStructures; ++s)
+        instance.memory[s] = -live[s];
+    //a copy of the module type holds the state of this generation
+    ModuleType modType(*job.modType);
+    modType.number = job.instance;
+    if (instance.cached) {
+        map<string, list<string> > below;
+        instance.module = InstanceCache::Load(instance.key, below);
+        modType.InitializeInstanceName();
+        instance.name = modType.InstanceName();
+        for (map<string, list<string> >::iterator hi = below.begin(); hi != below.end(); ++hi)
+            Globals::hierarchy[hi->first].splice(Globals::hierarchy[hi->first].end(), hi->second);
+        if (TopologicalOrder::On())
+            TopologicalOrder::Adopt(instance.module);
+    } else {
+        randomSeed(Seed(job.modType, job.instance));
+        Reserve(job.modType, job.instance);
+        instance.module = modType.GetInstance();
+        instance.name = modType.InstanceName();
+        if (InstanceCache::On()) {
+            map<string, list<string> > below;
+            Below(instance.name, below);
+            InstanceCache::Store(instance.key, instance.module, below);
+        }
+    }
+    for (int s = 0; s < moduleStructures; ++s)
+        instance.memory[s] += live[s];
+}
+
+unsigned int MacrocellScheduler::Seed(ModuleType *modType, int instance) {
+    unsigned int seed = argRead.seed;
+    const string &name = modType->Name();
+    for (string::const_iterator si = name.begin(); si != name.end(); ++si)
+        seed = seed * 31 + (unsigned char) *si;
+    return seed * 1000003u + instance;
+}
+
+//the hierarchy below the instance name: its own entry is on this thread, the ones of the instances
+//below it were merged when their level was done
+void MacrocellScheduler::Below(const string &name, map<string, list<string> > &below) {
+    map<string, list<string> >::iterator hi = Globals::hierarchy.find(name);
+    if (hi == Globals::hierarchy.end())
+        return;
+    below[name] = hi->second;
+    vector<string> stack(hi->second.begin(), hi->second.end());
+    lock_guard<mutex> guard(lock);
+    while (!stack.empty()) {
+        hi = hierarchy.find(stack.back());
+        stack.pop_back();
+        if (hi == hierarchy.end())
+            continue;
+        below[hi->first] = hi->second;
+        stack.insert(stack.end(), hi->second.begin(), hi->second.end());
+    }
+}
+
+//points the cursors of this thread to the instances taken by instance i of modType
+void MacrocellScheduler::Reserve(ModuleType *modType, int i) {
+    cursors.clear();
+    TypeInfo &info = types.find(modType)->second;
+    for (map<ModuleType *, int>::iterator ci = info.children.begin(); ci != info.children.end(); ++ci)
+        cursors[ci->first] = info.bases[ci->first] + i * ci->second;
+}
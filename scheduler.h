@@ -0,0 +1,127 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Scheduler
+#define _H_Scheduler
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include "modules.h"
+#include "statistics.h"
+
+using namespace std;
+
+//Pre-generation of the macrocell instances on -j threads (-pmi). The module types in the libraries
+//of a module type form a DAG; every instance a generation will need is generated up front, level
+//by level from the types without macrocells up, each level on a pool of threads. A worker borrows
+//the parsed libraries of the main thread and generates its instance on a copy of the module type,
+//so instances of the same type can be built at the same time. Instance k of a type is numbered k+1
+//and seeded from -seed, the type and k; instance p of a parent type takes a fixed slice of the
+//instances of each child type. The netlist therefore does not depend on the number of threads
+//(it differs from the serial generation, whose instances share one random sequence). With -cache,
+//the instances found in the InstanceCache are loaded instead, together with the ones below them.
+class MacrocellScheduler {
+public:
+    static bool On() { return argRead.parallelMacrocells || !argRead.cacheDir.empty(); }
+
+    //generates all the macrocell instances of the circuit; argc and argv are the command line
+    static void Run(int argc, char *argv[]);
+
+    //the next pre-generated instance of macroType for the generation on this thread, and its name;
+    //0 if the instances are not pre-generated
+    static Module *Take(ModuleType *macroType, string &instanceName);
+
+    //deletes the instances that were not taken
+    static void Clear();
+
+private:
+    //the structures owned by a module: blocks, nets, sinks and controllable outputs
+    static const int moduleStructures = Statistics::controllableOutputMemory + 1;
+
+    struct Instance {
+        Instance() : module(0), needed(0), cached(0) {}
+
+        Module *module;
+        string name;
+        string key;     //in the InstanceCache
+        bool needed;    //not below an instance that is loaded from the cache
+        bool cached;
+        long memory[moduleStructures];  //live bytes of the module, charged to the thread that takes it
+    };
+
+    struct TypeInfo {
+        TypeInfo() : level(0), count(0) {}
+
+        int level;                          //0 without macrocells, else one more than its deepest child
+        int count;                          //number of instances needed
+        map<ModuleType *, int> children;    //instances of each child type per instance
+        map<ModuleType *, int> bases;       //first instance of each child type taken by instance 0
+        vector<Instance> instances;
+    };
+
+    struct Job {
+        ModuleType *modType;
+        int instance;
+    };
+
+    static void Plan();
+
+    static bool LevelOrder(ModuleType *a, ModuleType *b);
+
+    static void Worker(vector<Job> &jobs);
+
+    static void Generate(Job &job);
+
+    static void Reserve(ModuleType *modType, int instance);
+
+    static unsigned int Seed(ModuleType *modType, int instance);
+
+    static vector<ModuleType *> Children(TypeInfo &info);
+
+    static void Below(const string &name, map<string, list<string> > &below);
+
+    static int argc;
+    static char **argv;
+    static map<string, Library> *libraries;
+    static Librarycell *flop;
+    static ModuleType *circuit;
+    static list<string> outputFormats, outputMacrocellFormats;
+    static map<ModuleType *, TypeInfo> types;
+    static atomic<int> next;
+    static atomic<bool> failed;
+    static mutex lock;
+    static string error;
+    static map<string, list<string> > hierarchy;
+    static thread_local map<ModuleType *, int> cursors;
+};
+
+#endif //{_H_Scheduler}
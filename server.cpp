@@ -0,0 +1,373 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "server.h"
+#include "argread.h"
+#include "pvtools.h"
+#include "scheduler.h"
+#include "checkpoint.h"
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+int GenerationServer::listenFd = -1;
+atomic<bool> GenerationServer::stopping(0);
+atomic<int> GenerationServer::requests(0);
+list<GenerationServer::Connection> GenerationServer::queue;
+mutex GenerationServer::queueLock;
+condition_variable GenerationServer::queueReady;
+mutex GenerationServer::processWide;
+multimap<string, GenerationServer::Spec *> GenerationServer::specs;
+mutex GenerationServer::specLock;
+
+void GenerationServer::Run() {
+    string path = argRead.serverSocket;
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        throw ("Socket path " + path + " is too long");
+    strcpy(address.sun_path, path.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        throw ("Cannot create socket: " + string(strerror(errno)));
+    //a socket that nobody listens on is left by a server that was killed
+    if (!connect(listenFd, (sockaddr *) &address, sizeof(address))) {
+        close(listenFd);
+        throw ("A server is already running on " + path);
+    }
+    close(listenFd);
+    unlink(path.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || bind(listenFd, (sockaddr *) &address, sizeof(address)) || listen(listenFd, 128))
+        throw ("Cannot listen on " + path + ": " + strerror(errno));
+
+    int numThreads = argRead.numThreads ? argRead.numThreads : int(thread::hardware_concurrency());
+    numThreads = max(1, numThreads);
+    lout << "Serving generation requests on " << path << " with " << numThreads << " threads.\n";
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; ++t)
+        workers.push_back(thread(Worker));
+
+    while (!stopping) {
+        int fd = accept(listenFd, 0, 0);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;      //the listening socket is shut down by a shutdown request
+        }
+        lock_guard<mutex> guard(queueLock);
+        queue.push_back(Connection(fd, chrono::steady_clock::now()));
+        queueReady.notify_one();
+    }
+    Stop();
+    for (vector<thread>::iterator ti = workers.begin(); ti != workers.end(); ++ti)
+        ti->join();
+    close(listenFd);
+    unlink(path.c_str());
+    for (multimap<string, Spec *>::iterator si = specs.begin(); si != specs.end(); ++si)
+        delete si->second;
+    specs.clear();
+    lout << "Server stopped after " << requests << " requests.\n";
+}
+
+void GenerationServer::Stop() {
+    lock_guard<mutex> guard(queueLock);
+    stopping = 1;
+    shutdown(listenFd, SHUT_RDWR);
+    queueReady.notify_all();
+}
+
+void GenerationServer::Worker() {
+    while (1) {
+        Connection connection;
+        {
+            unique_lock<mutex> guard(queueLock);
+            queueReady.wait(guard, [] { return !queue.empty() || stopping; });
+            if (queue.empty())
+                break;
+            connection = queue.front();
+            queue.pop_front();
+        }
+        Serve(connection);
+    }
+}
+
+void GenerationServer::Serve(Connection connection) {
+    int fd = connection.first;
+    Result result;
+    result.waitSeconds = chrono::duration<double>(chrono::steady_clock::now() - connection.second).count();
+    string buffer, line, cwd;
+    vector<string> args;
+    bool complete = 0;
+    while (ReadLine(fd, buffer, line)) {
+        if (line.empty()) {
+            complete = 1;
+            break;
+        }
+        if (line == "shutdown") {
+            Send(fd, "status ok\nend\n");
+            close(fd);
+            lout << "Shutdown requested.\n";
+            Stop();
+            return;
+        }
+        if (!line.compare(0, 4, "cwd "))
+            cwd = line.substr(4);
+        else if (!line.compare(0, 4, "arg "))
+            args.push_back(line.substr(4));
+        else
+            break;
+    }
+
+    int number = ++requests;
+    if (!complete || cwd.empty() || cwd[0] != '/')
+        result.error = "malformed request";
+    else
+        Generate(cwd, args, result);
+
+    string response;
+    if (result.ok) {
+        response = "status ok\ncircuit " + result.circuit + "\n";
+        response += stringPrintf("blocks %d\npins %d\ntargetPins %d\ngFrac %.4f\ntargetGFrac %.4f\n", result.numBlocks,
+                                 result.stats.numPins, result.stats.targetPins, result.stats.gFrac,
+                                 result.stats.targetGFrac);
+        response += string("resident ") + (result.resident ? "yes" : "no") + "\n";
+    } else
+        response = "status error\nerror " + result.error + "\n";
+    response += stringPrintf("waitSeconds %.3f\nparseSeconds %.3f\ngenerateSeconds %.3f\nend\n", result.waitSeconds,
+                             result.parseSeconds, result.generateSeconds);
+    Send(fd, response);
+    close(fd);
+    if (result.ok)
+        lout << stringPrintf("Request %d: %s, %d blocks in %.3f s.\n", number, result.circuit.c_str(),
+                             result.numBlocks, result.parseSeconds + result.generateSeconds);
+    else
+        lout << "Request " << number << ": " << result.error << ".\n";
+}
+
+void GenerationServer::Generate(const string &cwd, vector<string> args, Result &result) {
+    unique_lock<mutex> exclusive(processWide, defer_lock);
+    try {
+        args.insert(args.begin(), "gnl");
+        ReadArgs(args);
+        if (!argRead.serverSocket.empty() || !argRead.sweepFile.empty() || argRead.dryRun ||
+            !argRead.traceFile.empty())
+            throw ("-server, -sweep, -dry and -trace are not available in a request");
+
+        if (argRead.gnlFile.empty())
+            throw ("no gnl file in the request");
+
+        //the paths of the request, from the working directory of the client; the positional argument is the
+        //gnl file, the options given again replace the earlier ones
+        if (argRead.gnlFile[0] != '/')
+            for (vector<string>::reverse_iterator ai = args.rbegin(); ai != args.rend(); ++ai)
+                if (*ai == argRead.gnlFile) {
+                    *ai = Absolute(cwd, *ai);
+                    break;
+                }
+        args.push_back("-od");
+        args.push_back(Absolute(cwd, argRead.outputDir));
+        if (!argRead.cacheDir.empty()) {
+            args.push_back("-cache");
+            args.push_back(Absolute(cwd, argRead.cacheDir));
+        }
+        if (!argRead.checkpointDir.empty()) {
+            args.push_back("-checkpoint");
+            args.push_back(Absolute(cwd, argRead.checkpointDir));
+        }
+        ReadArgs(args);
+        argRead.showProgress = 0;
+        if (argRead.outputFormats.empty()) {
+            if (argRead.statisticsOnly) {
+                argRead.outputFormats.push_back("rtd");
+                argRead.outputFormats.push_back("dat");
+            } else
+                argRead.outputFormats.push_back("hnl");
+        }
+        if (argRead.writeAllModules)
+            argRead.outputMacrocellFormats = argRead.outputFormats;
+
+        InitializeGenerator();
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        //a resident spec is in Globals now, and deleted with them if the generation fails
+        string stamp = Stamp();
+        result.resident = Restore(stamp);
+        if (!result.resident)
+            ParseGnlFile();
+        chrono::steady_clock::time_point parsed = chrono::steady_clock::now();
+        result.parseSeconds = chrono::duration<double>(parsed - start).count();
+
+        if (MacrocellScheduler::On() || Checkpoint::On())
+            exclusive.lock();
+        if (Checkpoint::On())
+            Checkpoint::Begin();
+        vector<char *> argv;
+        for (vector<string>::iterator ai = args.begin(); ai != args.end(); ++ai)
+            argv.push_back(const_cast<char *>(ai->c_str()));
+        if (MacrocellScheduler::On())
+            MacrocellScheduler::Run(argv.size(), &argv[0]);
+        Module *module = Globals::circuit->GetInstance();
+        MacrocellScheduler::Clear();
+        Checkpoint::End();
+        result.generateSeconds = chrono::duration<double>(chrono::steady_clock::now() - parsed).count();
+        result.circuit = Globals::circuit->InstanceName();
+        result.numBlocks = module->NumBlocks();
+        result.stats = module->GetPinStatistics(Globals::circuit);
+        result.ok = 1;
+        delete module;
+        Keep(stamp);
+    }
+    catch (int e) {
+        result.error = "invalid options";
+    }
+    catch (char e) {
+        result.error = "invalid options";
+    }
+    catch (const char *msg) {
+        result.error = msg;
+    }
+    catch (const string &msg) {
+        result.error = msg;
+    }
+    catch (...) {
+        result.error = "internal error";
+    }
+    if (exclusive.owns_lock() && !result.ok)
+        MacrocellScheduler::Clear();
+    Globals::Clear();
+}
+
+void GenerationServer::ReadArgs(vector<string> &args) {
+    vector<char *> argv;
+    for (vector<string>::iterator ai = args.begin(); ai != args.end(); ++ai) {
+        if (ai->find_first_of(" \t") != string::npos)
+            throw ("argument with white space: " + *ai);
+        argv.push_back(const_cast<char *>(ai->c_str()));
+    }
+    argRead.AR_ReadArgs(argv.size(), &argv[0]);
+}
+
+string GenerationServer::Absolute(const string &cwd, const string &path) {
+    if (path.empty())
+        return cwd;
+    return path[0] == '/' ? path : cwd + "/" + path;
+}
+
+//what makes a parsed spec stale: the file, and the option the library cells are parsed with
+string GenerationServer::Stamp() {
+    struct stat st;
+    if (stat(argRead.gnlFile.c_str(), &st))
+        return "";
+    return stringPrintf("%lld.%09ld %lld %d", (long long) st.st_mtim.tv_sec, st.st_mtim.tv_nsec,
+                        (long long) st.st_size, int(argRead.areaAsWeight));
+}
+
+//the instances of a resident spec are numbered from the start again, as in a new process. The specs of
+//a file that changed are stale and deleted
+bool GenerationServer::Restore(const string &stamp) {
+    Spec *spec = 0;
+    {
+        lock_guard<mutex> guard(specLock);
+        pair<multimap<string, Spec *>::iterator, multimap<string, Spec *>::iterator> range =
+                specs.equal_range(argRead.gnlFile);
+        for (multimap<string, Spec *>::iterator si = range.first; si != range.second;) {
+            if (si->second->stamp == stamp && !spec)
+                spec = si->second;
+            else if (si->second->stamp == stamp) {
+                ++si;
+                continue;
+            } else
+                delete si->second;
+            specs.erase(si++);
+        }
+    }
+    if (!spec)
+        return 0;
+    Globals::libraries.swap(spec->libraries);
+    Globals::circuit = spec->circuit;
+    Globals::flop = spec->flop;
+    spec->circuit = 0;
+    delete spec;
+    Globals::circuit->number = 0;
+    for (map<string, Library>::iterator li = Globals::libraries.begin(); li != Globals::libraries.end(); ++li)
+        for (list<Cell *>::iterator ci = li->second.cells.begin(); ci != li->second.cells.end(); ++ci) {
+            ModuleType *modType = dynamic_cast<ModuleType *>(*ci);
+            if (modType)
+                modType->number = 0;
+        }
+    return 1;
+}
+
+void GenerationServer::Keep(const string &stamp) {
+    Spec *spec = new Spec;
+    spec->stamp = stamp;
+    spec->libraries.swap(Globals::libraries);
+    spec->circuit = Globals::circuit;
+    spec->flop = Globals::flop;
+    Globals::circuit = 0;
+    Globals::flop = 0;
+    lock_guard<mutex> guard(specLock);
+    specs.insert(pair<const string, Spec *>(argRead.gnlFile, spec));
+}
+
+bool GenerationServer::ReadLine(int fd, string &buffer, string &line) {
+    static const unsigned int maxRequest = 1 << 20;
+    size_t end;
+    while ((end = buffer.find('\n')) == string::npos) {
+        char chunk[4096];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0 || buffer.size() + n > maxRequest)
+            return 0;
+        buffer.append(chunk, n);
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return 1;
+}
+
+void GenerationServer::Send(int fd, const string &text) {
+    for (size_t sent = 0; sent < text.size();) {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;     //the client is gone
+        sent += n;
+    }
+}
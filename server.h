@@ -0,0 +1,132 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Server
+#define _H_Server
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include "main.h"
+
+using namespace std;
+
+//A resident generator (-server <socket>): generation requests come in over a Unix domain socket and run
+//on a pool of -j worker threads, each with generator state of its own (see Globals). The gnl files that
+//were parsed stay resident, so a request for a spec that was seen before skips ParseGnlFile and
+//CompleteRegions. A generation changes its module types, so a resident spec serves one request at a
+//time: requests for the same spec that run together parse a copy each, which then stays resident too.
+//A spec is parsed again when its file changes. Requests with -pmi, -cache or -checkpoint use state of
+//the process and run one at a time.
+//
+//The protocol is text, a line per item. A request is the working directory of the client and the
+//arguments of a gnl command line, ended by an empty line:
+//
+//  cwd <directory>
+//  arg <argument>
+//  ...
+//
+//Relative paths are taken from that directory, and the output files are written there unless -od is
+//given. The response is "status ok" or "status error" with "error <message>", then the circuit, its size
+//and the timing in seconds, a "<key> <value>" line each, and then "end". The request "shutdown" stops
+//the server once the requests that are running are done. gnlclient sends requests from the shell.
+class GenerationServer {
+public:
+    static void Run();
+
+private:
+    //a parsed gnl file: the libraries and the circuit that ParseGnlFile put in Globals
+    struct Spec {
+        Spec() : circuit(0), flop(0) {}
+
+        ~Spec() { delete circuit; }
+
+        string stamp;       //modification time and size of the file, and the options parsing depends on
+        map<string, Library> libraries;
+        ModuleType *circuit;
+        Librarycell *flop;
+    };
+
+    struct Result {
+        Result() : ok(0), resident(0), numBlocks(0), waitSeconds(0), parseSeconds(0), generateSeconds(0) {}
+
+        bool ok;
+        string error;
+        string circuit;
+        bool resident;      //the spec was parsed by an earlier request
+        int numBlocks;
+        Module::PinStatistics stats;
+        double waitSeconds, parseSeconds, generateSeconds;
+    };
+
+    typedef pair<int, chrono::steady_clock::time_point> Connection;
+
+    static void Worker();
+
+    static void Serve(Connection connection);
+
+    static void Generate(const string &cwd, vector<string> args, Result &result);
+
+    static void ReadArgs(vector<string> &args);
+
+    static string Absolute(const string &cwd, const string &path);
+
+    static string Stamp();
+
+    //an idle resident spec of the gnl file with the stamp, put in Globals; false if there is none
+    static bool Restore(const string &stamp);
+
+    //makes the spec in Globals resident
+    static void Keep(const string &stamp);
+
+    static void Stop();
+
+    static bool ReadLine(int fd, string &buffer, string &line);
+
+    static void Send(int fd, const string &text);
+
+    static int listenFd;
+    static atomic<bool> stopping;
+    static atomic<int> requests;
+    static list<Connection> queue;
+    static mutex queueLock;
+    static condition_variable queueReady;
+    static mutex processWide;           //held by the requests that use state of the process
+    static multimap<string, Spec *> specs;  //the idle resident specs, by gnl file
+    static mutex specLock;
+};
+
+#endif //{_H_Server}
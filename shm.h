@@ -0,0 +1,184 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Shm
+#define _H_Shm
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+//Netlist published in a POSIX shared memory segment (-w shm), for a consumer process on the same host.
+//The segment of circuit <name> is /gnl.<name>. It holds a ShmHeader followed by flat arrays, at the byte
+//offsets in the header, in native byte order:
+//
+//  cells       ShmCell[numCells], sorted on name; the names are in the string pool at names
+//  blockCells  int32_t[numBlocks], the cell of each block
+//  blockPins   uint64_t[numBlocks + 1], where the pins of each block start in pinNets
+//  pinNets     int32_t[], the net on each input pin and then on each output pin of a block
+//  netKinds    uint8_t[numNets], a ShmNetKind
+//  netSources  ShmPin[numNets], the output pin that drives a net; (-1, -1) for a circuit input
+//  netSinks    uint64_t[numNets + 1], where the sinks of each net start in sinks
+//  sinks       ShmPin[], the input pins on each net
+//
+//The circuit inputs are nets 0 to numInputs - 1, the circuit outputs the next numOutputs nets (the I/O
+//pads of the hnl format). The magic is written last: a consumer that finds it finds the complete
+//netlist. gnl replaces an existing segment, so a consumer that has mapped it keeps the old netlist; the
+//consumer removes the segment when it is done (ShmNetlist::Remove, or gnlshm <name> remove).
+
+enum ShmNetKind {
+    shmInput, shmOutput, shmInternal, shmUnlisted    //unlisted: feeds an inserted flop (see visitor.h)
+};
+
+struct ShmPin {
+    int32_t block;
+    int32_t pin;
+};
+
+struct ShmCell {
+    uint32_t name;
+    int32_t numInputs, numOutputs;
+    int32_t area;                       //as in the hnl format, the weight with -aw
+    int32_t sequential;
+    int32_t reserved;
+    double delay;
+};
+
+struct ShmHeader {
+    static const uint32_t version = 1;
+
+    char magic[8];                      //"GNLNETSH"
+    uint32_t headerVersion;
+    uint32_t headerSize;
+    uint64_t size;                      //of the segment
+    int32_t numCells, numBlocks, numNets, numInputs, numOutputs, reserved;
+    uint64_t numPins, numSinks;
+    uint64_t cells, names, blockCells, blockPins, pinNets, netKinds, netSources, netSinks, sinks;
+};
+
+//a read-only mapping of a published netlist
+class ShmNetlist {
+public:
+    ShmNetlist() : base(0), size(0) {}
+
+    ~ShmNetlist() { Close(); }
+
+    static string SegmentName(const string &circuit) { return "/gnl." + circuit; }
+
+    static bool Remove(const string &circuit) { return !shm_unlink(SegmentName(circuit).c_str()); }
+
+    //maps the netlist of the circuit; false, with the reason in error, if there is no complete netlist
+    bool Open(const string &circuit, string &error) {
+        Close();
+        string segment = SegmentName(circuit);
+        int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            error = "Can't open shared memory segment " + segment + ": " + strerror(errno);
+            return 0;
+        }
+        struct stat st;
+        if (fstat(fd, &st) || st.st_size < off_t(sizeof(ShmHeader))) {
+            close(fd);
+            error = "Shared memory segment " + segment + " holds no netlist";
+            return 0;
+        }
+        void *p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            error = "Can't map shared memory segment " + segment + ": " + strerror(errno);
+            return 0;
+        }
+        base = static_cast<const char *>(p);
+        size = st.st_size;
+        atomic_thread_fence(memory_order_acquire);
+        const ShmHeader &h = Header();
+        if (memcmp(h.magic, "GNLNETSH", 8) || h.size != size) {
+            Close();
+            error = "Shared memory segment " + segment + " holds no complete netlist";
+            return 0;
+        }
+        if (h.headerVersion != ShmHeader::version || h.headerSize != sizeof(ShmHeader)) {
+            Close();
+            error = "Shared memory segment " + segment + ": netlist version is not supported";
+            return 0;
+        }
+        return 1;
+    }
+
+    void Close() {
+        if (base)
+            munmap(const_cast<char *>(base), size);
+        base = 0;
+        size = 0;
+    }
+
+    const ShmHeader &Header() const { return *reinterpret_cast<const ShmHeader *>(base); }
+
+    const ShmCell &Cell(int c) const { return Array<ShmCell>(Header().cells)[c]; }
+
+    const char *CellName(int c) const { return base + Header().names + Cell(c).name; }
+
+    int BlockCell(int b) const { return Array<int32_t>(Header().blockCells)[b]; }
+
+    //the nets on the pins of a block: the inputs, then the outputs
+    int NumPins(int b) const { return int(Start(Header().blockPins, b + 1) - Start(Header().blockPins, b)); }
+
+    const int32_t *Pins(int b) const { return Array<int32_t>(Header().pinNets) + Start(Header().blockPins, b); }
+
+    ShmNetKind Kind(int n) const { return ShmNetKind(Array<uint8_t>(Header().netKinds)[n]); }
+
+    const ShmPin &Source(int n) const { return Array<ShmPin>(Header().netSources)[n]; }
+
+    int NumSinks(int n) const { return int(Start(Header().netSinks, n + 1) - Start(Header().netSinks, n)); }
+
+    const ShmPin *Sinks(int n) const { return Array<ShmPin>(Header().sinks) + Start(Header().netSinks, n); }
+
+private:
+    template<class T>
+    const T *Array(uint64_t offset) const { return reinterpret_cast<const T *>(base + offset); }
+
+    uint64_t Start(uint64_t offset, int i) const { return Array<uint64_t>(offset)[i]; }
+
+    ShmNetlist(const ShmNetlist &);
+
+    const char *base;
+    size_t size;
+};
+
+#endif //{_H_Shm}
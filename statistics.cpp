@@ -0,0 +1,217 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "statistics.h"
+#include "main.h"
+#include "pvtools.h"
+#include <sys/resource.h>
+
+const char *Statistics::phaseNames[numPhases] = {"ParseGnlFile", "CompleteRegions", "InitializeForrest",
+                                                 "BuildPartitionTree", "BuildModule", "DeletePartitionTree",
+                                                 "~Module"};
+const char *Statistics::counterNames[numCounters] = {"combines", "joinAttempts", "joinSuccesses", "flopsInserted",
+                                                     "controllableOutputsAdded"};
+const char *Statistics::structureNames[numStructures + 1] = {"blocks", "nets", "sinks", "controllableOutputs",
+                                                             "forrest", "treeNodes", "treeData", "total"};
+
+thread_local chrono::steady_clock::time_point Statistics::start;
+thread_local double Statistics::phaseSeconds[numPhases];
+thread_local int Statistics::phaseDepth[numPhases];
+thread_local map<string, double> Statistics::writerSeconds;
+thread_local PerfCounters::Values Statistics::phaseCounters[numPhases];
+thread_local map<string, PerfCounters::Values> Statistics::writerCounters;
+constinit thread_local long Statistics::counters[numCounters] = {};
+constinit thread_local long Statistics::controllableOutputsLive = 0;
+constinit thread_local long Statistics::controllableOutputsPeak = 0;
+constinit thread_local atomic<long> Statistics::memoryLive[numStructures + 1] = {};
+constinit thread_local long Statistics::memoryPeak[numStructures + 1] = {};
+
+void Statistics::Reset() {
+    start = chrono::steady_clock::now();
+    for (int p = 0; p < numPhases; ++p) {
+        phaseSeconds[p] = 0;
+        phaseDepth[p] = 0;
+        phaseCounters[p].Clear();
+    }
+    writerSeconds.clear();
+    writerCounters.clear();
+    for (int c = 0; c < numCounters; ++c)
+        counters[c] = 0;
+    controllableOutputsLive = controllableOutputsPeak = 0;
+    for (int s = 0; s <= numStructures; ++s) {
+        memoryLive[s].store(0, memory_order_relaxed);
+        memoryPeak[s] = 0;
+    }
+}
+
+//same units as the -dry estimate
+static string Size(double bytes) {
+    if (bytes < 10000)
+        return stringPrintf("%10.0f  B", bytes);
+    if (bytes < 1e7)
+        return stringPrintf("%10.1f kB", bytes / 1024);
+    if (bytes < 1e10)
+        return stringPrintf("%10.1f MB", bytes / 1024 / 1024);
+    return stringPrintf("%10.1f GB", bytes / 1024 / 1024 / 1024);
+}
+
+//memory section of the .info file
+void Statistics::WriteMemory(ostream &out, const string &prefix) {
+    out << prefix << "Memory use (peak, live at the time of writing):\n";
+    for (int s = 0; s <= numStructures; ++s)
+        out << prefix << stringPrintf("   %-20s", (string(structureNames[s]) + ":").c_str()) << Size(memoryPeak[s])
+            << "   (" << Size(memoryLive[s].load(memory_order_relaxed)) << ")\n";
+    out << prefix << stringPrintf("   %-20s", "peak RSS:") << Size(PeakResidentSetSize()) << "\n";
+    out << prefix << endl;
+}
+
+//peak resident set size of the process in bytes
+long Statistics::PeakResidentSetSize() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return 0;
+    return usage.ru_maxrss * 1024L;
+}
+
+static string JsonString(const string &s) {
+    string quoted = "\"";
+    for (string::const_iterator ci = s.begin(); ci != s.end(); ++ci) {
+        if (*ci == '"' || *ci == '\\')
+            quoted += '\\';
+        quoted += *ci;
+    }
+    return quoted + "\"";
+}
+
+static string JsonCounters(const PerfCounters::Values &v) {
+    string s = "{";
+    for (int e = 0; e < PerfCounters::numEvents; ++e)
+        if (PerfCounters::Available(e))
+            s += stringPrintf("%s\"%s\": %.0f", s.size() > 1 ? ", " : "", PerfCounters::Name(e), v.value[e]);
+    return s + "}";
+}
+
+void Statistics::WriteReport(const string &name, ModuleType *modType, Module *module) {
+    string filename = OutputFileName(name, "json");
+    ofstream out(filename.c_str());
+    if (!out)
+        throw ("Cannot open " + filename + " for writing");
+
+    Module::PinStatistics pins = module->GetPinStatistics(modType);
+    double total = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    out << "{\n";
+    out << "  \"gnl\": " << JsonString(Globals::version) << ",\n";
+    out << "  \"spec\": " << JsonString(argRead.gnlFile) << ",\n";
+    out << "  \"circuit\": " << JsonString(name) << ",\n";
+    out << "  \"blocks\": " << module->NumBlocks() << ",\n";
+    out << "  \"pins\": " << pins.numPins << ",\n";
+    out << "  \"targetPins\": " << pins.targetPins << ",\n";
+    out << "  \"seconds\": " << stringPrintf("%.6f", total) << ",\n";
+    out << "  \"phases\": {\n";
+    for (int p = 0; p < numPhases; ++p)
+        out << "    \"" << phaseNames[p] << "\": " << stringPrintf("%.6f", phaseSeconds[p]) <<
+            (p + 1 < numPhases ? ",\n" : "\n");
+    out << "  },\n";
+    out << "  \"writers\": {";
+    for (map<string, double>::iterator wi = writerSeconds.begin(); wi != writerSeconds.end(); ++wi)
+        out << (wi == writerSeconds.begin() ? "\n" : ",\n") << "    \"" << wi->first << "\": " <<
+            stringPrintf("%.6f", wi->second);
+    out << (writerSeconds.empty() ? "},\n" : "\n  },\n");
+    out << "  \"counters\": {\n";
+    for (int c = 0; c < numCounters; ++c)
+        out << "    \"" << counterNames[c] << "\": " << counters[c] << ",\n";
+    out << "    \"controllableOutputsPeak\": " << controllableOutputsPeak << "\n";
+    out << "  },\n";
+    out << "  \"memory\": {\n";
+    for (int s = 0; s <= numStructures; ++s)
+        out << "    \"" << structureNames[s] << "\": {\"live\": " << memoryLive[s].load(memory_order_relaxed) <<
+            ", \"peak\": " << memoryPeak[s] << (s < numStructures ? "},\n" : "}\n");
+    out << "  },\n";
+    if (argRead.perfCounters) {
+        string error;
+        out << "  \"perf\": {\n";
+        if (!PerfCounters::Open(error))
+            out << "    \"available\": false,\n    \"error\": " << JsonString(error) << "\n";
+        else {
+            out << "    \"available\": true,\n";
+            out << "    \"phases\": {\n";
+            for (int p = 0; p < numPhases; ++p)
+                if (p != deleteModule)
+                    out << "      \"" << phaseNames[p] << "\": " << JsonCounters(phaseCounters[p]) <<
+                        (p + 1 < numPhases && p + 1 != deleteModule ? ",\n" : "\n");
+            out << "    },\n";
+            out << "    \"writers\": {";
+            for (map<string, PerfCounters::Values>::iterator wi = writerCounters.begin(); wi != writerCounters.end(); ++wi)
+                out << (wi == writerCounters.begin() ? "\n" : ",\n") << "      \"" << wi->first << "\": " <<
+                    JsonCounters(wi->second);
+            out << (writerCounters.empty() ? "}\n" : "\n    }\n");
+        }
+        out << "  },\n";
+    }
+    out << "  \"peakRSS\": " << PeakResidentSetSize() << "\n";
+    out << "}\n";
+}
+
+PhaseTimer::PhaseTimer(Statistics::Phase p) : phase(p), outermost(Statistics::phaseDepth[p]++ == 0),
+                                               counting(outermost && p != Statistics::deleteModule &&
+                                                        PerfCounters::On()) {
+    if (counting)
+        PerfCounters::Read(counterStart);
+    if (outermost)
+        start = chrono::steady_clock::now();
+}
+
+PhaseTimer::PhaseTimer(const string &w) : phase(Statistics::numPhases), writer(w), outermost(1),
+                                          counting(PerfCounters::On()) {
+    if (counting)
+        PerfCounters::Read(counterStart);
+    start = chrono::steady_clock::now();
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (phase != Statistics::numPhases)
+        --Statistics::phaseDepth[phase];
+    if (!outermost)
+        return;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    PerfCounters::Values counterEnd;
+    if (counting)
+        PerfCounters::Read(counterEnd);
+    if (phase == Statistics::numPhases) {
+        Statistics::writerSeconds[writer] += seconds;
+        if (counting)
+            Statistics::writerCounters[writer].Add(counterEnd, counterStart);
+    } else {
+        Statistics::phaseSeconds[phase] += seconds;
+        if (counting)
+            Statistics::phaseCounters[phase].Add(counterEnd, counterStart);
+    }
+}
@@ -0,0 +1,153 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Statistics
+#define _H_Statistics
+
+#include <string>
+#include <map>
+#include <chrono>
+#include <atomic>
+#include <utility>
+#include <iostream>
+#include "perf.h"
+
+using namespace std;
+
+//Phase timers and counters of the generation run on this thread, reported in <name>.json (-w json).
+//Times are wall clock and inclusive; a phase that is entered again while it runs (macrocells) is
+//only timed by its outermost call.
+//
+//The heap memory of the main structures is accounted where they are allocated and freed, charged
+//with the malloc model of the -dry estimator. The live and peak bytes per structure go to the json
+//report and the .info file, the live total to the progress line.
+//
+//With -perf the phases and writers also collect hardware counters (see PerfCounters), except
+//~Module, which runs for every combination and would cost more than it measures.
+class Statistics {
+public:
+    enum Phase {
+        parse, completeRegions, initializeForrest, buildPartitionTree, buildModule, deletePartitionTree,
+        deleteModule, numPhases
+    };
+    enum Counter {
+        combines, joinAttempts, joinSuccesses, flopsInserted, controllableOutputsAdded, numCounters
+    };
+    enum Structure {
+        blockMemory, netMemory, sinkMemory, controllableOutputMemory, forrestMemory, treeNodeMemory,
+        treeDataMemory, numStructures
+    };
+
+    static void Reset();
+
+    static void Count(Counter c, long n = 1) { counters[c] += n; }
+
+    //change in the number of controllableOutputs entries, charged by their size in the DelayVectors
+    static void ControllableOutputs(long delta) {
+        if (delta > 0)
+            counters[controllableOutputsAdded] += delta;
+        controllableOutputsLive += delta;
+        if (controllableOutputsLive > controllableOutputsPeak)
+            controllableOutputsPeak = controllableOutputsLive;
+        Memory(controllableOutputMemory, delta * long(sizeof(pair<void *, double>)));
+    }
+
+    //bytes allocated (positive) or freed (negative) for a structure
+    static void Memory(Structure s, long bytes) {
+        //only this thread writes its counters, the progress reporter reads them
+        long live = memoryLive[s].load(memory_order_relaxed) + bytes;
+        memoryLive[s].store(live, memory_order_relaxed);
+        if (live > memoryPeak[s])
+            memoryPeak[s] = live;
+        live = memoryLive[numStructures].load(memory_order_relaxed) + bytes;
+        memoryLive[numStructures].store(live, memory_order_relaxed);
+        if (live > memoryPeak[numStructures])
+            memoryPeak[numStructures] = live;
+    }
+
+    //live bytes per structure of the calling thread, followed by their total
+    static const atomic<long> *LiveMemory() { return memoryLive; }
+
+    static const char *StructureName(int s) { return structureNames[s]; }
+
+    //heap bytes of an object: the request plus an 8 byte header, rounded up to 16 bytes, at least 32
+    static constexpr long Chunk(long bytes) { return bytes + 8 < 32 ? 32 : (bytes + 8 + 15) / 16 * 16; }
+
+    static constexpr long ListNode(long bytes) { return Chunk(2 * sizeof(void *) + bytes); }
+
+    static constexpr long MapNode(long bytes) { return Chunk(4 * sizeof(void *) + bytes); }
+
+    static void WriteMemory(ostream &out, const string &prefix);
+
+    static void WriteReport(const string &name, class ModuleType *modType, class Module *module);
+
+    static long PeakResidentSetSize();
+
+private:
+    static const char *phaseNames[numPhases];
+    static const char *counterNames[numCounters];
+    static const char *structureNames[numStructures + 1];
+
+    static thread_local chrono::steady_clock::time_point start;
+    static thread_local double phaseSeconds[numPhases];
+    static thread_local int phaseDepth[numPhases];
+    static thread_local map<string, double> writerSeconds;
+    static thread_local PerfCounters::Values phaseCounters[numPhases];
+    static thread_local map<string, PerfCounters::Values> writerCounters;
+    //constant initialized, so the counting functions access them directly
+    static constinit thread_local long counters[numCounters];
+    static constinit thread_local long controllableOutputsLive, controllableOutputsPeak;
+    static constinit thread_local atomic<long> memoryLive[numStructures + 1];
+    static constinit thread_local long memoryPeak[numStructures + 1];
+
+    friend class PhaseTimer;
+    friend class Checkpoint;
+};
+
+//times the phase (or output writer) for as long as it exists
+class PhaseTimer {
+public:
+    PhaseTimer(Statistics::Phase p);
+
+    PhaseTimer(const string &w);
+
+    ~PhaseTimer();
+
+private:
+    Statistics::Phase phase;
+    string writer;
+    bool outermost;
+    bool counting;
+    chrono::steady_clock::time_point start;
+    PerfCounters::Values counterStart;
+};
+
+#endif //{_H_Statistics}
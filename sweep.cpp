@@ -0,0 +1,243 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "main.h"
+#include "argread.h"
+#include "pvtools.h"
+#include "sweep.h"
+#include "trace.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <strings.h>
+
+//A sweep file lists the configurations to generate, e.g.
+//
+//  [grid]                          all combinations of the values below
+//  region = top 2500 p 0.55 0.6    <module> <region size> <parameter> <values>
+//  option = fip 0.05 0.1           <option> <values> (on/off for options without value)
+//
+//  [list]                          a single configuration
+//  region = top 2500 meanG 0.35
+//  option = nlc on
+//
+//Each configuration is generated with the command line of the sweep run, extended with its own
+//options and with its region parameters replacing those of the gnl file.
+
+struct SweepConfig {
+    list<string> arguments;
+    list<Globals::RegionOverride> regions;
+    string description;
+};
+
+struct SweepResult {
+    SweepResult() : ok(0), numBlocks(0), seconds(0) {}
+
+    bool ok;
+    string error;
+    int numBlocks;
+    double seconds;
+    Module::PinStatistics stats;
+};
+
+static void ReadSweepFile(const string &fileName, list<SweepConfig> &configs) {
+    LineParser parser(fileName.c_str());
+    lout << "Parsing sweep file " << fileName.c_str() << ".\n";
+    string section;
+    bool linesSkipped;
+    try {
+        while (parser.ReadNextSection(section, linesSkipped)) {
+            if (linesSkipped)
+                throw ("syntax error before section header");
+            bool grid = !strcasecmp(section.c_str(), "grid");
+            if (!grid && strcasecmp(section.c_str(), "list"))
+                throw ("unknown section type [" + section + "]");
+            list<SweepConfig> product(1);
+            string key, value;
+            list<string> words;
+            while (parser.ReadKey(key, value)) {
+                parser.SplitIntoWords(value, words);
+                list<SweepConfig> axis;
+                list<string>::iterator wi = words.begin();
+                if (!strcasecmp(key.c_str(), "region")) {
+                    if (words.size() < 4)
+                        throw ("region = <module> <size> <parameter> <values> expected");
+                    string module = *(wi++);
+                    int size = atoi((wi++)->c_str());
+                    string parameter = *(wi++);
+                    for (; wi != words.end(); ++wi) {
+                        SweepConfig config;
+                        config.regions.push_back(Globals::RegionOverride(module, size, parameter, atof(wi->c_str())));
+                        config.description = stringPrintf("%s.%d.%s=%s", module.c_str(), size, parameter.c_str(),
+                                                          wi->c_str());
+                        axis.push_back(config);
+                    }
+                } else if (!strcasecmp(key.c_str(), "option")) {
+                    if (words.size() < 2)
+                        throw ("option = <option> <values> expected");
+                    string option = "-" + *(wi++);
+                    for (; wi != words.end(); ++wi) {
+                        SweepConfig config;
+                        if (*wi != "off")
+                            config.arguments.push_back(option);
+                        if (*wi != "on" && *wi != "off")
+                            config.arguments.push_back(*wi);
+                        config.description = words.front() + "=" + *wi;
+                        axis.push_back(config);
+                    }
+                } else
+                    throw ("syntax error");
+                if (!grid && axis.size() != 1)
+                    throw ("only one value allowed in a [list] section");
+
+                //combine every configuration so far with every value of this key
+                list<SweepConfig> next;
+                for (list<SweepConfig>::iterator pi = product.begin(); pi != product.end(); ++pi)
+                    for (list<SweepConfig>::iterator ai = axis.begin(); ai != axis.end(); ++ai) {
+                        next.push_back(*pi);
+                        SweepConfig &config = next.back();
+                        config.arguments.insert(config.arguments.end(), ai->arguments.begin(), ai->arguments.end());
+                        config.regions.insert(config.regions.end(), ai->regions.begin(), ai->regions.end());
+                        if (!config.description.empty())
+                            config.description += " ";
+                        config.description += ai->description;
+                    }
+                product.swap(next);
+            }
+            configs.splice(configs.end(), product);
+        }
+    }
+    catch (const char *msg) {
+        throw (stringPrintf("%s:%d: %s", fileName.c_str(), parser.LineNumber(), msg));
+    }
+    catch (const string &msg) {
+        throw (stringPrintf("%s:%d: %s", fileName.c_str(), parser.LineNumber(), msg.c_str()));
+    }
+}
+
+static void GenerateConfiguration(int argc, char *argv[], SweepConfig &config, SweepResult &result) {
+    try {
+        vector<char *> args(argv, argv + argc);
+        for (list<string>::iterator ai = config.arguments.begin(); ai != config.arguments.end(); ++ai)
+            args.push_back(const_cast<char *>(ai->c_str()));
+        argRead.AR_ReadArgs(args.size(), &args[0]);
+        argRead.outputFormats.clear();
+        argRead.outputMacrocellFormats.clear();
+        argRead.showProgress = 0;
+        argRead.noWarnings = 1;
+        Globals::regionOverrides = config.regions;
+
+        InitializeGenerator();
+        ParseGnlFile();
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Module *module = Globals::circuit->GetInstance();
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        result.stats = module->GetPinStatistics(Globals::circuit);
+        result.numBlocks = module->NumBlocks();
+        result.ok = 1;
+        delete module;
+    }
+    catch (int e) {
+        result.error = "invalid options";
+    }
+    catch (const char *msg) {
+        result.error = msg;
+    }
+    catch (const string &msg) {
+        result.error = msg;
+    }
+    catch (...) {
+        result.error = "internal error";
+    }
+    Globals::Clear();
+}
+
+static void SweepWorker(int argc, char *argv[], vector<SweepConfig> &configs, vector<SweepResult> &results,
+                        atomic<int> &next) {
+    for (int n = next++; n < int(configs.size()); n = next++) {
+        Trace::BeginRun(n + 1);
+        GenerateConfiguration(argc, argv, configs[n], results[n]);
+        lout << "Sweep configuration " << (n + 1) << " of " << configs.size() << " done.\n";
+    }
+}
+
+static void WriteSweepTable(ostream &out, vector<SweepConfig> &configs, vector<SweepResult> &results) {
+    char buf[1024];
+    out << "#   config     blocks       pins   (target)  pinErr%    g_frac  (target) fracErr%    time[s]  settings\n";
+    for (unsigned int n = 0; n < configs.size(); ++n) {
+        const char *settings = configs[n].description.empty() ? "-" : configs[n].description.c_str();
+        Module::PinStatistics &stats = results[n].stats;
+        if (results[n].ok)
+            sprintf(buf, "%10d %10d %10d %10d %8.2f %9.4f %9.4f %8.2f %10.3f  %s\n", n + 1, results[n].numBlocks,
+                    stats.numPins, stats.targetPins, stats.PinError(), stats.gFrac, stats.targetGFrac,
+                    stats.FracError(), results[n].seconds, settings);
+        else
+            sprintf(buf, "%10d  error: %s  %s\n", n + 1, results[n].error.c_str(), settings);
+        out << buf;
+    }
+}
+
+void RunSweep(int argc, char *argv[]) {
+    list<SweepConfig> configList;
+    ReadSweepFile(argRead.sweepFile, configList);
+    vector<SweepConfig> configs(configList.begin(), configList.end());
+    if (configs.empty())
+        throw ("no configurations in sweep file " + argRead.sweepFile);
+
+    //check the gnl file once before starting the sweep
+    ParseGnlFile();
+    string name = Globals::circuit->Name();
+    Globals::Clear();
+
+    int numThreads = argRead.numThreads ? argRead.numThreads : int(thread::hardware_concurrency());
+    numThreads = max(1, min(numThreads, int(configs.size())));
+    lout << "Running " << configs.size() << " sweep configurations on " << numThreads << " threads.\n";
+
+    vector<SweepResult> results(configs.size());
+    atomic<int> next(0);
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; ++t)
+        workers.push_back(thread(SweepWorker, argc, argv, ref(configs), ref(results), ref(next)));
+    for (vector<thread>::iterator ti = workers.begin(); ti != workers.end(); ++ti)
+        ti->join();
+
+    string filename = OutputFileName(name, "sweep");
+    ofstream out(filename.c_str());
+    if (!out)
+        throw ("Cannot open " + filename + " for writing");
+    out << "# Sweep " << argRead.sweepFile << " of " << argRead.gnlFile << " generated by gnl " << Globals::version
+        << " on " << time << endl;
+    out << "# Command line: " << argRead.ar_commandLine << endl << endl;
+    WriteSweepTable(out, configs, results);
+    WriteSweepTable(cout, configs, results);
+}
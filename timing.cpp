@@ -0,0 +1,102 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "timing.h"
+
+void PathTiming::AddBlock(Module *module, Librarycell *cell) {
+    if (!On() || cell->Sequential())
+        return;
+    for (list<Module::InputNet *>::iterator ii = module->inputs.begin(); ii != module->inputs.end(); ++ii)
+        for (list<Module::OutputNet *>::iterator oi = module->outputs.begin(); oi != module->outputs.end(); ++oi)
+            (*ii)->controllableOutputs.Insert(*oi, cell->Delay());
+    Statistics::ControllableOutputs(long(module->inputs.size()) * module->outputs.size());
+}
+
+Module::OutputNet::Connection PathTiming::Check(Module::OutputNet *outputNet, Module::InputNet *inputNet,
+                                                double delayScaleFactor) {
+    Module::OutputNet::Connection connection = Module::OutputNet::connectable;
+    //check if path is not too long
+    if (outputNet->maxLength > delayScaleFactor * inputNet->allowedMaxLength)
+        connection = Module::OutputNet::needsFlop;
+    //check if path is not too short
+    if (outputNet->maxLength < delayScaleFactor * inputNet->requiredMinLength)
+        return Module::OutputNet::tooShort;
+    return connection;
+}
+
+void PathTiming::Connect(Module::OutputNet *outputNet, Module::InputNet *inputNet, Module *modA, Module *modB,
+                         Module *modC) {
+    //arrival times of the outputs inputNet controls
+    DelayVector<Module::OutputNet> &cone = inputNet->controllableOutputs;
+    for (DelayVector<Module::OutputNet>::const_iterator ci = cone.begin(); ci != cone.end(); ++ci)
+        ci->first->maxLength = max(ci->first->maxLength, ci->second + outputNet->maxLength);
+
+    //the inputs that control outputNet now also control inputNet's cone, and get its required times
+    for (Module *mod = modA; mod; mod = (mod == modA) ? modB : (mod == modB) ? modC : 0)
+        for (list<Module::InputNet *>::iterator li = mod->inputs.begin(); li != mod->inputs.end(); ++li) {
+            double *delay = (*li)->controllableOutputs.Find(outputNet);
+            if (!delay)
+                continue;
+            double d = *delay;
+            long size = (*li)->controllableOutputs.size();
+            (*li)->controllableOutputs.Merge(cone, d);
+            Statistics::ControllableOutputs((*li)->controllableOutputs.size() - size);
+            double len = inputNet->allowedMaxLength - d;
+            if (len < 0)
+                throw ("Internal error: allowedMaxLength<0");
+            if (len < (*li)->allowedMaxLength)
+                (*li)->allowedMaxLength = len;
+
+            len = max(0.0, inputNet->requiredMinLength - d);
+            if (len > (*li)->requiredMinLength)
+                (*li)->requiredMinLength = len;
+        }
+}
+
+void PathTiming::MergeInputs(Module::InputNet *inputNet, Module::InputNet *other) {
+    if (On()) {
+        long size = inputNet->controllableOutputs.size();
+        inputNet->controllableOutputs.Merge(other->controllableOutputs, 0);
+        Statistics::ControllableOutputs(inputNet->controllableOutputs.size() - size);
+    }
+    inputNet->requiredMinLength = max(inputNet->requiredMinLength, other->requiredMinLength);
+    inputNet->allowedMaxLength = min(inputNet->allowedMaxLength, other->allowedMaxLength);
+}
+
+void PathTiming::Remove(Module::OutputNet *outputNet, Module *modA, Module *modB, Module *modC) {
+    if (!On())
+        return;
+    long erased = 0;
+    for (Module *mod = modA; mod; mod = (mod == modA) ? modB : (mod == modB) ? modC : 0)
+        for (list<Module::InputNet *>::iterator li = mod->inputs.begin(); li != mod->inputs.end(); ++li)
+            erased += (*li)->controllableOutputs.Erase(outputNet);
+    Statistics::ControllableOutputs(-erased);
+}
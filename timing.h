@@ -0,0 +1,72 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Timing
+#define _H_Timing
+
+#include "modules.h"
+
+using namespace std;
+
+//Path length bookkeeping, used when loops are not allowed and path lengths are bounded.
+//
+//Arrival times: OutputNet::maxLength is the longest path from a module input or a flop to the net.
+//Required times: InputNet::allowedMaxLength and requiredMinLength bound the path from the net to
+//a flop. InputNet::controllableOutputs holds the longest path from the input to every module output
+//it drives combinationally, which is both the cone that a connection updates and the loop check.
+//The paths of a connection are only propagated one level: to the outputs the joined input
+//controls and to the inputs that control the joined output. Outputs that become internal nets
+//leave the cones.
+class PathTiming {
+public:
+    static bool On() { return !argRead.allowLoops && !argRead.allowLongPaths; }
+
+    //the cones of the single block module a library cell is turned into
+    static void AddBlock(Module *module, Librarycell *cell);
+
+    //whether outputNet is allowed to drive inputNet, given the path lengths and the scale factor
+    //of the combination
+    static Module::OutputNet::Connection Check(Module::OutputNet *outputNet, Module::InputNet *inputNet,
+                                               double delayScaleFactor);
+
+    //updates the arrival and required times and the cones for the connection of outputNet to
+    //inputNet; the inputs that can control outputNet are the ones of modA, modB and modC
+    static void Connect(Module::OutputNet *outputNet, Module::InputNet *inputNet, Module *modA, Module *modB,
+                        Module *modC);
+
+    //inputNet takes over the cone and the required times of other
+    static void MergeInputs(Module::InputNet *inputNet, Module::InputNet *other);
+
+    //outputNet is no longer a module output (internal net, or driven by an inserted flop)
+    static void Remove(Module::OutputNet *outputNet, Module *modA, Module *modB, Module *modC);
+};
+
+#endif //{_H_Timing}
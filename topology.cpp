@@ -0,0 +1,153 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "topology.h"
+#include <algorithm>
+
+constinit thread_local int TopologicalOrder::next = 0;
+thread_local vector<Module::Block *> TopologicalOrder::stack;
+thread_local vector<Module::Block *> TopologicalOrder::forward;
+thread_local vector<Module::Block *> TopologicalOrder::backward;
+thread_local vector<int> TopologicalOrder::orders;
+
+void TopologicalOrder::Adopt(Module *module) {
+    vector<Module::Block *> blocks(module->blocks.begin(), module->blocks.end());
+    sort(blocks.begin(), blocks.end(), OrderLess);
+    for (vector<Module::Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
+        Add(*bi);
+}
+
+bool TopologicalOrder::Loop(Module::OutputNet *outputNet, Module::InputNet *inputNet) {
+    Module::Block *driver = outputNet->source.first;
+    if (!Combinational(driver))
+        return 0;
+    forward.clear();
+    bool loop = 0;
+    for (list<Module::Terminal>::iterator ti = inputNet->sinks.begin(); ti != inputNet->sinks.end() && !loop; ++ti)
+        if (ti->first->order <= driver->order && Combinational(ti->first))
+            loop = Forward(ti->first, driver);
+    Unmark(forward);
+    return loop;
+}
+
+void TopologicalOrder::Connect(Module::OutputNet *outputNet, Module::InputNet *inputNet) {
+    Module::Block *driver = outputNet->source.first;
+    if (!Combinational(driver))
+        return;
+    for (list<Module::Terminal>::iterator ti = inputNet->sinks.begin(); ti != inputNet->sinks.end(); ++ti) {
+        Module::Block *sink = ti->first;
+        if (sink->order > driver->order || !Combinational(sink))
+            continue;
+        forward.clear();
+        if (Forward(sink, driver))
+            throw ("Internal error: connection closes a combinational loop");
+        backward.clear();
+        Backward(driver, sink->order);
+        Unmark(forward);
+        Unmark(backward);
+        Renumber();
+    }
+}
+
+//marks and collects the blocks reachable from 'from' that are ordered before the driver; returns
+//whether the driver is one of them
+bool TopologicalOrder::Forward(Module::Block *from, Module::Block *driver) {
+    if (from == driver)
+        return 1;
+    if (from->mark)
+        return 0;
+    from->mark = 1;
+    forward.push_back(from);
+    stack.clear();
+    stack.push_back(from);
+    while (!stack.empty()) {
+        Module::Block *block = stack.back();
+        stack.pop_back();
+        for (vector<Module::OutputNet *>::iterator oi = block->outputs.begin(); oi != block->outputs.end(); ++oi)
+            for (list<Module::Terminal>::iterator ti = (*oi)->sinks.begin(); ti != (*oi)->sinks.end(); ++ti) {
+                Module::Block *sink = ti->first;
+                if (sink == driver)
+                    return 1;
+                if (!sink->mark && sink->order < driver->order && Combinational(sink)) {
+                    sink->mark = 1;
+                    forward.push_back(sink);
+                    stack.push_back(sink);
+                }
+            }
+    }
+    return 0;
+}
+
+//collects the blocks the driver is reachable from that are ordered after 'lower'
+void TopologicalOrder::Backward(Module::Block *driver, int lower) {
+    driver->mark = 1;
+    backward.push_back(driver);
+    stack.clear();
+    stack.push_back(driver);
+    while (!stack.empty()) {
+        Module::Block *block = stack.back();
+        stack.pop_back();
+        for (vector<Module::Net *>::iterator ni = block->inputs.begin(); ni != block->inputs.end(); ++ni) {
+            *ni = Module::Net::Find(*ni);
+            if (!(*ni)->Driven())
+                continue;
+            Module::Block *source = static_cast<Module::OutputNet *>(*ni)->source.first;
+            if (!source->mark && source->order > lower && Combinational(source)) {
+                source->mark = 1;
+                backward.push_back(source);
+                stack.push_back(source);
+            }
+        }
+    }
+}
+
+void TopologicalOrder::Unmark(vector<Module::Block *> &blocks) {
+    for (vector<Module::Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
+        (*bi)->mark = 0;
+}
+
+//gives the order numbers of both sets to the driver's ancestors first, keeping the relative order
+//within each set
+void TopologicalOrder::Renumber() {
+    sort(forward.begin(), forward.end(), OrderLess);
+    sort(backward.begin(), backward.end(), OrderLess);
+    orders.clear();
+    for (vector<Module::Block *>::iterator bi = backward.begin(); bi != backward.end(); ++bi)
+        orders.push_back((*bi)->order);
+    for (vector<Module::Block *>::iterator bi = forward.begin(); bi != forward.end(); ++bi)
+        orders.push_back((*bi)->order);
+    sort(orders.begin(), orders.end());
+    vector<int>::iterator oi = orders.begin();
+    for (vector<Module::Block *>::iterator bi = backward.begin(); bi != backward.end(); ++bi)
+        (*bi)->order = *oi++;
+    for (vector<Module::Block *>::iterator bi = forward.begin(); bi != forward.end(); ++bi)
+        (*bi)->order = *oi++;
+}
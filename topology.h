@@ -0,0 +1,87 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Topology
+#define _H_Topology
+
+#include <vector>
+#include "modules.h"
+
+using namespace std;
+
+//Loop check by an incremental topological order of the combinational blocks (Pearce and Kelly),
+//used instead of the controllable output sets when path lengths are not bounded (-ap).
+//Every combinational block has an order number, and every connection from a combinational
+//block to another one goes to a higher number. Connecting an output net to an input net adds an
+//edge from the driver of the output net to every sink of the input net. Only the sinks that are
+//ordered before the driver can close a loop, and only the blocks ordered between them and the
+//driver have to be searched and renumbered.
+class TopologicalOrder {
+public:
+    static bool On() { return !argRead.allowLoops && argRead.allowLongPaths; }
+
+    static void Add(Module::Block *block) {
+        block->order = next++;
+        block->mark = 0;
+    }
+
+    //whether connecting outputNet to inputNet would close a combinational loop
+    static bool Loop(Module::OutputNet *outputNet, Module::InputNet *inputNet);
+
+    //renumbers the blocks for the connection of outputNet to inputNet; call it before the join
+    static void Connect(Module::OutputNet *outputNet, Module::InputNet *inputNet);
+
+    static void Clear() { next = 0; }
+
+    //renumbers the blocks of a module generated on another thread, keeping their order
+    static void Adopt(Module *module);
+
+private:
+    static bool Combinational(Module::Block *block) { return !block->cell->Sequential(); }
+
+    static bool OrderLess(Module::Block *a, Module::Block *b) { return a->order < b->order; }
+
+    static bool Forward(Module::Block *from, Module::Block *driver);
+
+    static void Backward(Module::Block *driver, int lower);
+
+    static void Unmark(vector<Module::Block *> &blocks);
+
+    static void Renumber();
+
+    static constinit thread_local int next;
+    static thread_local vector<Module::Block *> stack, forward, backward;
+    static thread_local vector<int> orders;
+
+    friend class Checkpoint;
+};
+
+#endif //{_H_Topology}
@@ -0,0 +1,116 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include "trace.h"
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+//Records are collected in a buffer per thread and appended to the file a block at a time, so the
+//combine loop only copies a record. Blocks of different threads (sweep) are written whole.
+
+static const int blockSize = 4096;
+
+static FILE *traceFile = 0;
+static mutex traceLock;
+
+bool Trace::enabled = 0;
+
+static void WriteBlock(const TraceRecord *records, int n) {
+    lock_guard<mutex> guard(traceLock);
+    if (traceFile && fwrite(records, sizeof(TraceRecord), n, traceFile) != size_t(n))
+        throw ("Cannot write trace file");
+}
+
+struct TraceBuffer {
+    TraceBuffer() : run(0) {
+        records.reserve(blockSize);
+    }
+
+    ~TraceBuffer() {
+        try {
+            Flush();
+        }
+        catch (...) {
+        }
+    }
+
+    void Flush() {
+        if (!records.empty())
+            WriteBlock(&records[0], records.size());
+        records.clear();
+    }
+
+    int run;
+    vector<TraceRecord> records;
+};
+
+static TraceBuffer &Buffer() {
+    //allocated on first use: most threads never trace
+    static thread_local TraceBuffer buffer;
+    return buffer;
+}
+
+void Trace::Open(const string &fileName) {
+    lock_guard<mutex> guard(traceLock);
+    if (!(traceFile = fopen(fileName.c_str(), "wb")))
+        throw ("Cannot open " + fileName + " for writing");
+    TraceHeader header;
+    memcpy(header.magic, "GNLTRACE", 8);
+    header.version = version;
+    header.recordSize = sizeof(TraceRecord);
+    if (fwrite(&header, sizeof(header), 1, traceFile) != 1)
+        throw ("Cannot write " + fileName);
+    enabled = 1;
+}
+
+void Trace::Close() {
+    if (!enabled)
+        return;
+    Buffer().Flush();
+    lock_guard<mutex> guard(traceLock);
+    enabled = 0;
+    fclose(traceFile);
+    traceFile = 0;
+}
+
+void Trace::BeginRun(int run) {
+    if (enabled)
+        Buffer().run = run;
+}
+
+void Trace::Write(const TraceRecord &record) {
+    TraceBuffer &buffer = Buffer();
+    buffer.records.push_back(record);
+    buffer.records.back().run = buffer.run;
+    if (int(buffer.records.size()) == blockSize)
+        buffer.Flush();
+}
@@ -0,0 +1,118 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Trace
+#define _H_Trace
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+//Binary trace of the combine decisions (-trace <file>), decoded with gnltrace.
+//The file holds a TraceHeader followed by fixed-size TraceRecords, in native byte order.
+
+struct TraceHeader {
+    char magic[8];              //"GNLTRACE"
+    uint32_t version;
+    uint32_t recordSize;
+};
+
+struct TraceRecord {
+    enum Type {
+        combineRecord = 1, flopRecord = 2
+    };
+    enum FlopReason {
+        loop = 1, longPath = 2
+    };
+
+    //one record per Module::Module(modA, modB, modType)
+    struct Combine {
+        int32_t moduleA, moduleB;
+        int32_t blocksA, blocksB;
+        int32_t ia, oa, ib, ob;
+        int32_t targetI, targetO;       //from the Rent parameters
+        int32_t se, si;                 //external and internal connections aimed for
+        int32_t aToB, bToA;             //phase 1
+        int32_t internal;               //phase 2
+        int32_t inputCombinations;      //phase 3
+        int32_t localOutputs;           //phase 4
+        int32_t localInternal;          //phase 5
+        int32_t localInputs;            //phase 6
+        int32_t joinAttempts;           //phase 1 and 4, successful or not
+        int32_t flops;
+        int32_t resultI, resultO;
+    };
+
+    //one record per flop inserted to break a loop or a long path
+    struct Flop {
+        int32_t reason;
+        int32_t blocks;                 //blocks of the module being built
+        float maxLength;                //of the output net
+        float allowedMaxLength;         //of the input net
+        float delayScaleFactor;
+    };
+
+    TraceRecord(int t, int m) {
+        memset(this, 0, sizeof(TraceRecord));
+        type = t;
+        module = m;
+    }
+
+    int32_t type;
+    int32_t run;                        //sweep configuration, 0 for a single generation
+    int32_t module;                     //number the module being built will get
+    union {
+        Combine combine;
+        Flop flop;
+    };
+};
+
+class Trace {
+public:
+    static const uint32_t version = 1;
+
+    static void Open(const string &fileName);
+
+    static void Close();
+
+    static void BeginRun(int run);
+
+    static bool On() { return enabled; }
+
+    static void Write(const TraceRecord &record);
+
+private:
+    static bool enabled;
+};
+
+#endif //{_H_Trace}
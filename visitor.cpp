@@ -0,0 +1,154 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#include <unordered_map>
+#include <algorithm>
+#include "main.h"
+#include "visitor.h"
+
+static bool CellNameLess(Librarycell *a, Librarycell *b) {
+    return a->Name() < b->Name();
+}
+
+static bool CellNameEqual(Librarycell *a, Librarycell *b) {
+    return a->Name() == b->Name();
+}
+
+void Module::Visit(const vector<NetlistVisitor *> &visitors, ModuleType *modType) {
+    if (visitors.empty())
+        return;
+    typedef vector<NetlistVisitor *>::const_iterator VisitorIt;
+
+    NetlistVisitor::Header header = {modType->InstanceName(), modType, this, numBlocks, numInputs, numOutputs,
+                                     int(inputs.size() + outputs.size() + internalNets.size()), 0, 0, 0, 0};
+    for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi) {
+        header.numBlockInputs += (*bi)->inputs.size();
+        header.numBlockPins += (*bi)->inputs.size() + (*bi)->outputs.size();
+    }
+    for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
+        header.numInputSinks += (*ni)->sinks.size();
+    for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
+        header.numOutputSinks += (*ni)->sinks.size();
+    for (list<OutputNet *>::iterator ni = internalNets.begin(); ni != internalNets.end(); ++ni)
+        header.numOutputSinks += (*ni)->sinks.size();
+    for (VisitorIt vi = visitors.begin(); vi != visitors.end(); ++vi)
+        (*vi)->Begin(header);
+
+    //the cells, once per name
+    vector<Librarycell *> cells;
+    {
+        unordered_map<Librarycell *, bool> seen;
+        for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
+            if (seen.insert(pair<Librarycell *, bool>((*bi)->cell, 1)).second)
+                cells.push_back((*bi)->cell);
+        stable_sort(cells.begin(), cells.end(), CellNameLess);
+        cells.erase(unique(cells.begin(), cells.end(), CellNameEqual), cells.end());
+    }
+    for (vector<Librarycell *>::iterator ci = cells.begin(); ci != cells.end(); ++ci)
+        for (VisitorIt vi = visitors.begin(); vi != visitors.end(); ++vi)
+            (*vi)->VisitCell(*ci);
+
+    //the blocks, numbering the nets as they are met
+    unordered_map<Net *, int> netIds;
+    unordered_map<Block *, int> blockIds;
+    vector<Net *> nets;
+    netIds.reserve(header.numNets);
+    blockIds.reserve(numBlocks);
+    nets.reserve(header.numNets);
+    for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni) {
+        netIds[*ni] = nets.size();
+        nets.push_back(*ni);
+    }
+    for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni) {
+        netIds[*ni] = nets.size();
+        nets.push_back(*ni);
+    }
+    vector<int> inputIds, outputIds;
+    for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi) {
+        Block *block = *bi;
+        int id = blockIds.size();
+        blockIds[block] = id;
+        inputIds.clear();
+        outputIds.clear();
+        for (vector<Net *>::iterator ni = block->inputs.begin(); ni != block->inputs.end(); ++ni) {
+            pair<unordered_map<Net *, int>::iterator, bool> n = netIds.insert(pair<Net *, int>(*ni, nets.size()));
+            if (n.second)
+                nets.push_back(*ni);
+            inputIds.push_back(n.first->second);
+        }
+        for (vector<OutputNet *>::iterator ni = block->outputs.begin(); ni != block->outputs.end(); ++ni) {
+            pair<unordered_map<Net *, int>::iterator, bool> n = netIds.insert(pair<Net *, int>(*ni, nets.size()));
+            if (n.second)
+                nets.push_back(*ni);
+            outputIds.push_back(n.first->second);
+        }
+        for (VisitorIt vi = visitors.begin(); vi != visitors.end(); ++vi)
+            (*vi)->VisitBlock(id, block->cell, inputIds, outputIds);
+    }
+
+    //the nets, in the order of the net lists
+    vector<bool> visited(nets.size());
+    vector<NetlistVisitor::Pin> sinks;
+    for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
+        VisitNet(visitors, *ni, NetlistVisitor::input, netIds, blockIds, visited, sinks);
+    for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
+        VisitNet(visitors, *ni, NetlistVisitor::output, netIds, blockIds, visited, sinks);
+    for (list<OutputNet *>::iterator ni = internalNets.begin(); ni != internalNets.end(); ++ni)
+        VisitNet(visitors, *ni, NetlistVisitor::internal, netIds, blockIds, visited, sinks);
+    for (unsigned int n = 0; n < nets.size(); ++n)
+        if (!visited[n])
+            VisitNet(visitors, nets[n], NetlistVisitor::unlisted, netIds, blockIds, visited, sinks);
+
+    for (VisitorIt vi = visitors.begin(); vi != visitors.end(); ++vi)
+        (*vi)->End();
+}
+
+void Module::VisitNet(const vector<NetlistVisitor *> &visitors, Net *net, NetlistVisitor::NetKind kind, unordered_map<Net *, int> &netIds,
+                      unordered_map<Block *, int> &blockIds, vector<bool> &visited,
+                      vector<NetlistVisitor::Pin> &sinks) {
+    //an internal net without sinks or an unconnected output is on no pin of a block that was met before
+    pair<unordered_map<Net *, int>::iterator, bool> n = netIds.insert(pair<Net *, int>(net, visited.size()));
+    if (n.second)
+        visited.push_back(0);
+    int id = n.first->second;
+    visited[id] = 1;
+
+    NetlistVisitor::Pin source(-1, -1);
+    if (net->Driven()) {
+        Terminal &t = static_cast<OutputNet *>(net)->source;
+        source = NetlistVisitor::Pin(blockIds[t.first], t.second);
+    }
+    sinks.clear();
+    for (list<Terminal>::iterator ti = net->sinks.begin(); ti != net->sinks.end(); ++ti)
+        sinks.push_back(NetlistVisitor::Pin(blockIds[ti->first], ti->second));
+    for (vector<NetlistVisitor *>::const_iterator vi = visitors.begin(); vi != visitors.end(); ++vi)
+        (*vi)->VisitNet(id, kind, source, sinks);
+}
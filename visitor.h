@@ -0,0 +1,93 @@
+/**************************************************************************
+***
+*** Copyright (c) 1998-2001 Peter Verplaetse, Dirk Stroobandt
+***
+***  Contact author: pvrplaet@elis.rug.ac.be
+***  Affiliation:   Ghent University
+***                 Department of Electronics and Information Systems
+***                 St.-Pietersnieuwstraat 41
+***                 9000 Gent, Belgium
+***
+***  Permission is hereby granted, free of charge, to any person obtaining
+***  a copy of this software and associated documentation files (the
+***  "Software"), to deal in the Software without restriction, including
+***  without limitation
+***  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+***  and/or sell copies of the Software, and to permit persons to whom the
+***  Software is furnished to do so, subject to the following conditions:
+***
+***  The above copyright notice and this permission notice shall be included
+***  in all copies or substantial portions of the Software.
+***
+*** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+*** EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+*** OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*** IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+*** CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+*** OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+*** THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+***
+***************************************************************************/
+
+#ifndef _H_Visitor
+#define _H_Visitor
+
+#include <string>
+#include <vector>
+#include "libraries.h"
+
+using namespace std;
+
+class Module;
+
+class ModuleType;
+
+//A consumer of a generated netlist. Module::Visit streams the netlist to any number of visitors in one
+//pass: the library cells in use (sorted on name), then every block with the nets on its pins, then
+//every net with its source and sinks, so a consumer never needs a copy of the netlist. Blocks are
+//numbered in the order of the blocks list; nets in the order they are first met: the circuit inputs,
+//the circuit outputs, then the pins of the blocks. The file formats (hnl, netD, netD2, nets) are
+//visitors too (see write.cpp); other visitors of the circuit are added to Globals::visitors.
+class NetlistVisitor {
+public:
+    struct Header {
+        const string &name;     //instance name
+        ModuleType *modType;
+        Module *module;
+        int numBlocks;
+        int numInputs;
+        int numOutputs;
+        int numNets;            //circuit inputs, circuit outputs and internal nets
+        int numBlockPins;       //input and output pins of the blocks
+        int numBlockInputs;     //input pins of the blocks, the sinks of all the nets
+        int numInputSinks;      //sinks of the circuit inputs
+        int numOutputSinks;     //sinks of the circuit outputs and internal nets
+    };
+
+    //unlisted nets are driven by a block but in no net list of the module: the nets that feed the flops
+    //inserted on an output net (see OutputNet::AddFlop). They are streamed last; the file formats skip them
+    enum NetKind {
+        input, output, internal, unlisted
+    };
+
+    //a block and the number of one of its input pins, or of its output pin for the source of a net
+    typedef pair<int, int> Pin;
+
+    virtual ~NetlistVisitor() {}
+
+    virtual void Begin(const Header &header) {}
+
+    virtual void VisitCell(Librarycell *cell) {}
+
+    virtual void VisitBlock(int block, Librarycell *cell, const vector<int> &inputs, const vector<int> &outputs) {}
+
+    //the source of a circuit input is (-1, -1)
+    virtual void VisitNet(int net, NetKind kind, const Pin &source, const vector<Pin> &sinks) {}
+
+    virtual void End() {}
+
+    //the writer of a file format that holds the netlist, or 0 for the other formats (see write.cpp)
+    static NetlistVisitor *Writer(const string &format, const string &name);
+};
+
+#endif //{_H_Visitor}
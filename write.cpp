@@ -33,7 +33,10 @@
 #include "argread.h"
 #include "debug.h"
 #include "pvtools.h"
+#include "visitor.h"
+#include "shm.h"
 #include <cmath>
+#include <unordered_map>
 
 int CounterMap::operator[](void *p) {
     pair<map<void *, int>::iterator, bool> mi = counterMap.insert(pair<void *const, int>(p, next));
@@ -43,7 +46,7 @@ int CounterMap::operator[](void *p) {
 }
 
 void Module::WriteTree(const string &name, ModuleType *modType) {
-    string filename = name + ".tree";
+    string filename = OutputFileName(name, "tree");
     ofstream out(filename.c_str());
     if (!out)
         throw ("Cannot open " + filename + " for writing");
@@ -61,7 +64,7 @@ void Module::WriteTree(const string &name, ModuleType *modType) {
 }
 
 void Module::WritePtree(const string &name, ModuleType *modType) {
-    string filename = name + ".ptree";
+    string filename = OutputFileName(name, "ptree");
     ofstream out(filename.c_str());
     if (!out)
         throw ("Cannot open " + filename + " for writing");
@@ -79,211 +82,424 @@ void Module::WritePtree(const string &name, ModuleType *modType) {
     }
 }
 
-void Module::WriteHnl(const string &name, ModuleType *modType) {
-    //get map of all the library cells
-    map<string, Librarycell *> cells;
-    for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
-        cells[(*bi)->cell->Name()] = (*bi)->cell;
+//numbers the blocks in the order they are first written (netD, netD2)
+class BlockNumbers {
+public:
+    BlockNumbers() : next(0) {}
 
-    string filename = name + ".hnl";
-    ofstream out(filename.c_str());
+    void Resize(int numBlocks) { numbers.assign(numBlocks, -1); }
+
+    int operator[](int block) {
+        if (numbers[block] < 0)
+            numbers[block] = next++;
+        return numbers[block];
+    }
+
+private:
+    vector<int> numbers;
+    int next;
+};
+
+static void OpenOutput(ofstream &out, const string &filename) {
+    out.open(filename.c_str());
     if (!out)
         throw ("Cannot open " + filename + " for writing");
+}
 
-    out << "# Netlist " << name << " generated by gnl " << Globals::version << " on " << time << endl;
-    WriteInfoHeader(out, modType, "# ");
+class HnlWriter : public NetlistVisitor {
+public:
+    HnlWriter(const string &n) : name(n), numInputs(0), numOutputs(0), circuitWritten(0) {}
+
+    void Begin(const Header &header) {
+        OpenOutput(out, OutputFileName(name, "hnl"));
+        out << "# Netlist " << name << " generated by gnl " << Globals::version << " on " << time << endl;
+        header.module->WriteInfoHeader(out, header.modType, "# ");
+        numInputs = header.numInputs;
+        numOutputs = header.numOutputs;
+    }
 
     //write library cells
-    for (map<string, Librarycell *>::iterator li = cells.begin(); li != cells.end(); ++li) {
-        out << (li->second->Sequential() ? "sequential " : "combinational ") << li->first << endl;
-        if (li->second->I()) {
+    void VisitCell(Librarycell *cell) {
+        out << (cell->Sequential() ? "sequential " : "combinational ") << cell->Name() << endl;
+        if (cell->I()) {
             out << "input";
-            for (int i = 1; i <= li->second->I(); ++i)
+            for (int i = 1; i <= cell->I(); ++i)
                 out << " i" << i;
             out << endl;
         }
-        if (li->second->O()) {
+        if (cell->O()) {
             out << "output";
-            for (int i = 1; i <= li->second->O(); ++i)
+            for (int i = 1; i <= cell->O(); ++i)
                 out << " o" << i;
             out << endl;
         }
-        out << "area " << (argRead.areaAsWeight ? li->second->Weight() : li->second->Size()) << endl;
+        out << "area " << (argRead.areaAsWeight ? cell->Weight() : cell->Size()) << endl;
         out << "end\n\n";
     }
 
-    //write blocklist
-    out << "circuit " << name << endl;
-    CounterMap netMap;
-    if (!inputs.empty()) {
-        out << "input";
-        for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
-            out << " n" << netMap[*ni];
+    //write blocklist; the inputs and outputs are the first nets
+    void VisitBlock(int block, Librarycell *cell, const vector<int> &inputs, const vector<int> &outputs) {
+        if (!circuitWritten)
+            WriteCircuit();
+        out << cell->Name();
+        for (vector<int>::const_iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
+            out << " n" << *ni;
+        for (vector<int>::const_iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
+            out << " n" << *ni;
         out << endl;
     }
-    if (!outputs.empty()) {
-        out << "output";
-        for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
-            out << " n" << netMap[*ni];
-        out << endl;
+
+    void End() {
+        if (!circuitWritten)
+            WriteCircuit();
+        out << "end\n";
     }
 
-    for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi) {
-        out << (*bi)->cell->Name();
-        for (vector<Net *>::iterator ni = (*bi)->inputs.begin(); ni != (*bi)->inputs.end(); ++ni)
-            out << " n" << netMap[*ni];
-        for (vector<OutputNet *>::iterator ni = (*bi)->outputs.begin(); ni != (*bi)->outputs.end(); ++ni)
-            out << " n" << netMap[*ni];
-        out << endl;
+private:
+    void WriteCircuit() {
+        out << "circuit " << name << endl;
+        if (numInputs) {
+            out << "input";
+            for (int n = 0; n < numInputs; ++n)
+                out << " n" << n;
+            out << endl;
+        }
+        if (numOutputs) {
+            out << "output";
+            for (int n = numInputs; n < numInputs + numOutputs; ++n)
+                out << " n" << n;
+            out << endl;
+        }
+        circuitWritten = 1;
     }
-    out << "end\n";
-}
 
-void Module::WriteNetD(const string &name) {
-    string filename = name + ".netD";
-    ofstream out(filename.c_str());
-    if (!out)
-        throw ("Cannot open " + filename + " for writing");
+    string name;
+    ofstream out;
+    int numInputs, numOutputs;
+    bool circuitWritten;
+};
+
+class NetDWriter : public NetlistVisitor {
+public:
+    NetDWriter(const string &n) : name(n), padCounter(0) {}
+
+    void Begin(const Header &header) {
+        OpenOutput(out, OutputFileName(name, "netD"));
+        int pads = header.numInputs + header.numOutputs;
+        out << "0\n";
+        out << (header.numBlockPins + pads) << endl;
+        out << header.numNets << endl;
+        out << (header.numBlocks + pads) << endl;
+        out << (header.numBlocks - 1) << endl;
+        cellMap.Resize(header.numBlocks);
+    }
 
-    out << "0\n";
-    out << (TotalPinCount() + numInputs + numOutputs) << endl;
-    out << (internalNets.size() + numInputs + numOutputs) << endl;
-    out << (numBlocks + numInputs + numOutputs) << endl;
-    out << (numBlocks - 1) << endl;
-
-    int padCounter = 0;
-    CounterMap cellMap;
-
-    for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
-        (*ni)->WriteNetD(out, cellMap, padCounter);
-    for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
-        (*ni)->WriteNetD(out, cellMap, padCounter, 1);
-    for (list<OutputNet *>::iterator ni = internalNets.begin(); ni != internalNets.end(); ++ni)
-        (*ni)->WriteNetD(out, cellMap, padCounter);
-}
+    void VisitNet(int net, NetKind kind, const Pin &source, const vector<Pin> &sinks) {
+        if (kind == unlisted)
+            return;
+        if (kind == input)
+            out << 'p' << (++padCounter) << " s O\n";
+        else
+            out << 'a' << cellMap[source.first] << " s O\n";
+        if (kind == output)
+            out << 'p' << (++padCounter) << " l I\n";
+        for (vector<Pin>::const_iterator ti = sinks.begin(); ti != sinks.end(); ++ti)
+            out << 'a' << cellMap[ti->first] << " l I\n";
+    }
 
-void Module::WriteNets(const string &name, ModuleType *modType) {
-    string filename = name + ".nodes";
-    ofstream out(filename.c_str());
-    if (!out)
-        throw ("Cannot open " + filename + " for writing");
+private:
+    string name;
+    ofstream out;
+    BlockNumbers cellMap;
+    int padCounter;
+};
+
+class NetD2Writer : public NetlistVisitor {
+public:
+    NetD2Writer(const string &n) : name(n), padCounter(0) {}
+
+    void Begin(const Header &header) {
+        OpenOutput(out, OutputFileName(name, "netD2"));
+        int numIn = header.numInputSinks, numOut = header.numOutputSinks + header.numOutputs;
+        out << "0\n";
+        out << 2 * (numIn + numOut) << endl;
+        out << numIn + numOut << endl;
+        out << header.numBlocks + header.numOutputs + numIn << endl;
+        out << header.numBlocks - 1 << endl;
+        cellMap.Resize(header.numBlocks);
+    }
 
-    CounterMap cellMap;
-    out << "UCLA nodes 1.0\n";
-    out << "# Netlist " << name << " generated by gnl " << Globals::version << " on " << time << endl;
-    WriteInfoHeader(out, modType, "# ");
-    out << "NumNodes : " << (numBlocks + numInputs + numOutputs) << endl;
-    out << "NumTerminals : " << (numInputs + numOutputs) << endl;
+    void VisitNet(int net, NetKind kind, const Pin &source, const vector<Pin> &sinks) {
+        if (kind == unlisted)
+            return;
+        if (kind == input) {
+            for (vector<Pin>::const_iterator ti = sinks.begin(); ti != sinks.end(); ++ti) {
+                out << 'p' << (++padCounter) << " s O\n";
+                out << 'a' << cellMap[ti->first] << " l I\n";
+            }
+            return;
+        }
+        if (kind == output) {
+            out << 'a' << cellMap[source.first] << " s O\n";
+            out << 'p' << (++padCounter) << " l I\n";
+        }
+        for (vector<Pin>::const_iterator ti = sinks.begin(); ti != sinks.end(); ++ti) {
+            out << 'a' << cellMap[source.first] << " s O\n";
+            out << 'a' << cellMap[ti->first] << " l I\n";
+        }
+    }
 
-    for (int i = 1; i <= numInputs + numOutputs; ++i)
-        out << "pad_" << i << " terminal\n";
-    for (list<Block *>::iterator bi = blocks.begin(); bi != blocks.end(); ++bi)
-        out << (*bi)->cell->Name() << '_' << cellMap[*bi] << endl;
-    out.close();
+private:
+    string name;
+    ofstream out;
+    BlockNumbers cellMap;
+    int padCounter;
+};
+
+//UCLA nodes and nets; the blocks are numbered in the order of the blocks list
+class NetsWriter : public NetlistVisitor {
+public:
+    NetsWriter(const string &n) : name(n), padCounter(0) {}
+
+    void Begin(const Header &header) {
+        OpenOutput(nodes, OutputFileName(name, "nodes"));
+        nodes << "UCLA nodes 1.0\n";
+        nodes << "# Netlist " << name << " generated by gnl " << Globals::version << " on " << time << endl;
+        header.module->WriteInfoHeader(nodes, header.modType, "# ");
+        int pads = header.numInputs + header.numOutputs;
+        nodes << "NumNodes : " << (header.numBlocks + pads) << endl;
+        nodes << "NumTerminals : " << pads << endl;
+        for (int i = 1; i <= pads; ++i)
+            nodes << "pad_" << i << " terminal\n";
+
+        OpenOutput(nets, OutputFileName(name, "nets"));
+        nets << "UCLA nets  1.0\n";
+        nets << "# Netlist " << name << " generated by gnl " << Globals::version << " on " << time << endl;
+        header.module->WriteInfoHeader(nets, header.modType, "# ");
+        nets << "NumNets : " << header.numNets << endl;
+        nets << "NumPins : " << (header.numBlockPins + pads) << endl;
+        cells.reserve(header.numBlocks);
+    }
 
-    filename = name + ".nets";
-    out.open(filename.c_str());
-    if (!out)
-        throw ("Cannot open " + filename + " for writing");
+    void VisitBlock(int block, Librarycell *cell, const vector<int> &inputs, const vector<int> &outputs) {
+        nodes << cell->Name() << '_' << block << endl;
+        cells.push_back(cell);
+    }
 
-    out << "UCLA nets  1.0\n";
-    out << "# Netlist " << name << " generated by gnl " << Globals::version << " on " << time << endl;
-    WriteInfoHeader(out, modType, "# ");
-    out << "NumNets : " << (internalNets.size() + numInputs + numOutputs) << endl;
-    out << "NumPins : " << (TotalPinCount() + numInputs + numOutputs) << endl;
-
-    int padCounter = 0;
-    for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
-        (*ni)->WriteNets(out, cellMap, padCounter);
-    for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
-        (*ni)->WriteNets(out, cellMap, padCounter, 1);
-    for (list<OutputNet *>::iterator ni = internalNets.begin(); ni != internalNets.end(); ++ni)
-        (*ni)->WriteNets(out, cellMap, padCounter);
-}
+    void VisitNet(int net, NetKind kind, const Pin &source, const vector<Pin> &sinks) {
+        if (kind == unlisted)
+            return;
+        nets << "NetDegree : " << (sinks.size() + (kind == output) + 1) << endl;
+        if (kind == input)
+            nets << "pad_" << (++padCounter) << " O\n";
+        else
+            nets << cells[source.first]->Name() << '_' << source.first << " O\n";
+        if (kind == output)
+            nets << "pad_" << (++padCounter) << " I\n";
+        for (vector<Pin>::const_iterator ti = sinks.begin(); ti != sinks.end(); ++ti)
+            nets << cells[ti->first]->Name() << '_' << ti->first << " I\n";
+    }
 
-void Module::WriteNetD2(const string &name) {
-    string filename = name + ".netD2";
-    ofstream out(filename.c_str());
-    if (!out)
-        throw ("Cannot open " + filename + " for writing");
+private:
+    string name;
+    ofstream nodes, nets;
+    vector<Librarycell *> cells;
+    int padCounter;
+};
+
+//the netlist in a shared memory segment, for a consumer process (see shm.h). The size of every array is
+//known when the stream begins, except for the cell names: the segment is created once the cells are in.
+//The sinks of a net are counted on the block pins, so that every net gets its place by its number
+class ShmWriter : public NetlistVisitor {
+public:
+    ShmWriter(const string &n) : name(n), segment(ShmNetlist::SegmentName(n)), base(0), size(0),
+                                 sinksPlaced(0), complete(0) {}
+
+    ~ShmWriter() {
+        if (base)
+            munmap(base, size);
+        if (base && !complete)
+            shm_unlink(segment.c_str());
+    }
 
-    int numIn = 0, numOut = 0;
-    for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
-        numIn += (*ni)->sinks.size();
-    for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
-        numOut += (*ni)->sinks.size() + 1;
-    for (list<OutputNet *>::iterator ni = internalNets.begin(); ni != internalNets.end(); ++ni)
-        numOut += (*ni)->sinks.size();
-
-    out << "0\n";
-    out << 2 * (numIn + numOut) << endl;
-    out << numIn + numOut << endl;
-    out << numBlocks + numOutputs + numIn << endl;
-    out << numBlocks - 1 << endl;
-
-    int padCounter = 0;
-    CounterMap cellMap;
-
-    for (list<InputNet *>::iterator ni = inputs.begin(); ni != inputs.end(); ++ni)
-        (*ni)->WriteNetD2(out, cellMap, padCounter);
-    for (list<OutputNet *>::iterator ni = outputs.begin(); ni != outputs.end(); ++ni)
-        (*ni)->WriteNetD2(out, cellMap, padCounter, 1);
-    for (list<OutputNet *>::iterator ni = internalNets.begin(); ni != internalNets.end(); ++ni)
-        (*ni)->WriteNetD2(out, cellMap, padCounter);
-}
+    void Begin(const Header &header) {
+        memset(&shm, 0, sizeof(shm));
+        shm.headerVersion = ShmHeader::version;
+        shm.headerSize = sizeof(ShmHeader);
+        shm.numBlocks = header.numBlocks;
+        shm.numInputs = header.numInputs;
+        shm.numOutputs = header.numOutputs;
+        //every net is driven by a circuit input or by an output pin of a block
+        shm.numNets = header.numInputs + header.numBlockPins - header.numBlockInputs;
+        shm.numPins = header.numBlockPins;
+        shm.numSinks = header.numBlockInputs;
+    }
 
-void Module::Net::WriteNetD(ofstream &out, CounterMap &cellMap) {
-    for (list<Terminal>::iterator ti = sinks.begin(); ti != sinks.end(); ++ti)
-        out << 'a' << cellMap[ti->first] << " l I\n";
-}
+    void VisitCell(Librarycell *cell) { cells.push_back(cell); }
+
+    void VisitBlock(int block, Librarycell *cell, const vector<int> &inputs, const vector<int> &outputs) {
+        if (!base)
+            Create();
+        Array<int32_t>(shm.blockCells)[block] = CellIndex(cell);
+        uint64_t *blockPins = Array<uint64_t>(shm.blockPins);
+        uint64_t pin = blockPins[block];
+        if (pin + inputs.size() + outputs.size() > shm.numPins)
+            throw ("Internal error: more block pins than counted for " + segment);
+        int32_t *pinNets = Array<int32_t>(shm.pinNets);
+        uint64_t *netSinks = Array<uint64_t>(shm.netSinks);
+        for (vector<int>::const_iterator ni = inputs.begin(); ni != inputs.end(); ++ni) {
+            CheckNet(*ni);
+            pinNets[pin++] = *ni;
+            ++netSinks[*ni + 1];
+        }
+        for (vector<int>::const_iterator ni = outputs.begin(); ni != outputs.end(); ++ni) {
+            CheckNet(*ni);
+            pinNets[pin++] = *ni;
+        }
+        blockPins[block + 1] = pin;
+    }
 
-void Module::InputNet::WriteNetD(ofstream &out, CounterMap &cellMap, int &padCounter) {
-    out << 'p' << (++padCounter) << " s O\n";
-    Net::WriteNetD(out, cellMap);
-}
+    void VisitNet(int net, NetKind kind, const Pin &source, const vector<Pin> &sinks) {
+        if (!base)
+            Create();
+        if (!sinksPlaced)
+            PlaceSinks();
+        CheckNet(net);
+        uint64_t *netSinks = Array<uint64_t>(shm.netSinks);
+        if (netSinks[net + 1] - netSinks[net] != sinks.size())
+            throw ("Internal error: sinks of a net not on the block pins for " + segment);
+        Array<uint8_t>(shm.netKinds)[net] = kind;     //ShmNetKind has the order of NetKind
+        ShmPin *pin = Array<ShmPin>(shm.netSources) + net;
+        pin->block = source.first;
+        pin->pin = source.second;
+        pin = Array<ShmPin>(shm.sinks) + netSinks[net];
+        for (vector<Pin>::const_iterator ti = sinks.begin(); ti != sinks.end(); ++ti, ++pin) {
+            pin->block = ti->first;
+            pin->pin = ti->second;
+        }
+    }
 
-void Module::OutputNet::WriteNetD(ofstream &out, CounterMap &cellMap, int &padCounter, bool external) {
-    out << 'a' << cellMap[source.first] << " s O\n";
-    if (external)
-        out << 'p' << (++padCounter) << " l I\n";
-    Net::WriteNetD(out, cellMap);
-}
+    //the magic goes in last, when the netlist is complete
+    void End() {
+        if (!base)
+            Create();
+        if (!sinksPlaced)
+            PlaceSinks();
+        atomic_thread_fence(memory_order_release);
+        memcpy(base, "GNLNETSH", 8);
+        complete = 1;
+        lout << "Published the netlist of " << name << " in shared memory segment " << segment << ".\n";
+    }
 
-void Module::Net::WriteNets(ofstream &out, CounterMap &cellMap) {
-    for (list<Terminal>::iterator ti = sinks.begin(); ti != sinks.end(); ++ti)
-        out << ti->first->cell->Name() << '_' << cellMap[ti->first] << " I\n";
-}
+private:
+    static uint64_t Align(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
 
-void Module::InputNet::WriteNets(ofstream &out, CounterMap &cellMap, int &padCounter) {
-    out << "NetDegree : " << (sinks.size() + 1) << endl;
-    out << "pad_" << (++padCounter) << " O\n";
-    Net::WriteNets(out, cellMap);
-}
+    template<class T>
+    T *Array(uint64_t offset) { return reinterpret_cast<T *>(base + offset); }
 
-void Module::OutputNet::WriteNets(ofstream &out, CounterMap &cellMap, int &padCounter, bool external) {
-    out << "NetDegree : " << (sinks.size() + external + 1) << endl;
-    out << source.first->cell->Name() << '_' << cellMap[source.first] << " O\n";
-    if (external)
-        out << "pad_" << (++padCounter) << " I\n";
-    Net::WriteNets(out, cellMap);
-}
+    void CheckNet(int net) {
+        if (net < 0 || net >= shm.numNets)
+            throw ("Internal error: more nets than counted for " + segment);
+    }
 
-void Module::InputNet::WriteNetD2(ofstream &out, CounterMap &cellMap, int &padCounter) {
-    for (list<Terminal>::iterator ti = sinks.begin(); ti != sinks.end(); ++ti) {
-        out << 'p' << (++padCounter) << " s O\n";
-        out << 'a' << cellMap[ti->first] << " l I\n";
+    void Create() {
+        uint64_t namesSize = 0;
+        for (vector<Librarycell *>::iterator ci = cells.begin(); ci != cells.end(); ++ci)
+            namesSize += (*ci)->Name().size() + 1;
+        shm.numCells = cells.size();
+        shm.cells = Align(sizeof(ShmHeader));
+        shm.names = Align(shm.cells + shm.numCells * sizeof(ShmCell));
+        shm.blockCells = Align(shm.names + namesSize);
+        shm.blockPins = Align(shm.blockCells + shm.numBlocks * sizeof(int32_t));
+        shm.pinNets = Align(shm.blockPins + (shm.numBlocks + 1) * sizeof(uint64_t));
+        shm.netKinds = Align(shm.pinNets + shm.numPins * sizeof(int32_t));
+        shm.netSources = Align(shm.netKinds + shm.numNets * sizeof(uint8_t));
+        shm.netSinks = Align(shm.netSources + shm.numNets * sizeof(ShmPin));
+        shm.sinks = Align(shm.netSinks + (shm.numNets + 1) * sizeof(uint64_t));
+        shm.size = size = shm.sinks + shm.numSinks * sizeof(ShmPin);
+
+        //a consumer that has the old segment mapped keeps it
+        shm_unlink(segment.c_str());
+        int fd = shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+            throw ("Cannot create shared memory segment " + segment + ": " + strerror(errno));
+        if (ftruncate(fd, size)) {
+            string error = strerror(errno);
+            close(fd);
+            shm_unlink(segment.c_str());
+            throw ("Cannot size shared memory segment " + segment + ": " + error);
+        }
+        void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            shm_unlink(segment.c_str());
+            throw ("Cannot map shared memory segment " + segment + ": " + strerror(errno));
+        }
+        base = static_cast<char *>(p);
+
+        //the segment starts out zero: the header without its magic, then the cells
+        memcpy(base, &shm, sizeof(shm));
+        ShmCell *shmCell = Array<ShmCell>(shm.cells);
+        char *names = Array<char>(shm.names);
+        uint32_t nameOffset = 0;
+        for (unsigned int c = 0; c < cells.size(); ++c, ++shmCell) {
+            Librarycell *cell = cells[c];
+            shmCell->name = nameOffset;
+            shmCell->numInputs = cell->I();
+            shmCell->numOutputs = cell->O();
+            shmCell->area = argRead.areaAsWeight ? cell->Weight() : cell->Size();
+            shmCell->sequential = cell->Sequential();
+            shmCell->delay = cell->Delay();
+            memcpy(names + nameOffset, cell->Name().c_str(), cell->Name().size() + 1);
+            nameOffset += cell->Name().size() + 1;
+            cellIndex[cell] = c;
+        }
     }
-}
 
-void Module::OutputNet::WriteNetD2(ofstream &out, CounterMap &cellMap, int &padCounter, bool external) {
-    if (external) {
-        out << 'a' << cellMap[source.first] << " s O\n";
-        out << 'p' << (++padCounter) << " l I\n";
+    //a cell of another library with the same name as a streamed one is that cell
+    int CellIndex(Librarycell *cell) {
+        unordered_map<Librarycell *, int>::iterator ci = cellIndex.find(cell);
+        if (ci != cellIndex.end())
+            return ci->second;
+        for (unsigned int c = 0; c < cells.size(); ++c)
+            if (cells[c]->Name() == cell->Name())
+                return cellIndex[cell] = c;
+        throw ("Internal error: block of a cell that was not streamed for " + segment);
     }
-    for (list<Terminal>::iterator ti = sinks.begin(); ti != sinks.end(); ++ti) {
-        out << 'a' << cellMap[source.first] << " s O\n";
-        out << 'a' << cellMap[ti->first] << " l I\n";
+
+    //turns the sink counts into the starts of the sinks of every net
+    void PlaceSinks() {
+        uint64_t *netSinks = Array<uint64_t>(shm.netSinks);
+        for (int n = 0; n < shm.numNets; ++n)
+            netSinks[n + 1] += netSinks[n];
+        if (netSinks[shm.numNets] != shm.numSinks)
+            throw ("Internal error: fewer block pins than counted for " + segment);
+        sinksPlaced = 1;
     }
+
+    string name;
+    string segment;
+    ShmHeader shm;
+    vector<Librarycell *> cells;
+    unordered_map<Librarycell *, int> cellIndex;
+    char *base;
+    uint64_t size;
+    bool sinksPlaced;
+    bool complete;
+};
+
+NetlistVisitor *NetlistVisitor::Writer(const string &format, const string &name) {
+    if (format == "hnl")
+        return new HnlWriter(name);
+    if (format == "netD")
+        return new NetDWriter(name);
+    if (format == "netD2")
+        return new NetD2Writer(name);
+    if (format == "nets")
+        return new NetsWriter(name);
+    if (format == "shm")
+        return new ShmWriter(name);
+    return 0;
 }
 
 void Module::WriteInfoHeader(ofstream &info, ModuleType *modType, string prefix) {
@@ -328,18 +544,20 @@ void Module::WriteInfoHeader(ofstream &info, ModuleType *modType, string prefix)
 }
 
 void Module::WriteInfo(const string &name, ModuleType *modType) {
-    string filename = name + ".info";
+    string filename = OutputFileName(name, "info");
     ofstream info(filename.c_str());
     if (!info)
         throw ("Cannot open " + filename + " for writing");
     info << "Netlist " << name << " generated by gnl " << Globals::version << " on " << time << endl;
     WriteInfoHeader(info, modType);
+    if (Globals::circuit == modType)
+        Statistics::WriteMemory(info, "");
 }
 
 void Module::WritePlots(const string &name, ModuleType *modType) {
     modType->WriteRtd(name);
     modType->WriteDat(name);
-    string filename = name + ".plot";
+    string filename = OutputFileName(name, "plot");
     ofstream plot(filename.c_str());
     if (!plot)
         throw ("Cannot open " + filename + " for writing");
@@ -373,10 +591,13 @@ void ModuleType::WriteRtd(const string &name) {
     if (forrest.size() != 1)
         throw ("Internal error: forrest is not a tree");
     map<int, map<int, int> > rtd;
-    forrest.begin()->second->AddRtdData(rtd);
+    PartitionTree &tree = partitionTree;
+    for (int node = 0; node < tree.Size(); ++node)
+        ++(rtd[tree.kinds[node] == PartitionTree::compound ? tree.area[node] : tree.numBlocks[node]]
+           [tree.NumTerminals(node)]);
 
     //write rtd file
-    string filename = name + ".rtd";
+    string filename = OutputFileName(name, "rtd");
     ofstream out(filename.c_str());
     char buf[1024];
     if (!out)
@@ -398,7 +619,7 @@ void ModuleType::WriteDat(const string &name) {
     FillBuckets();
 
     //write dat file
-    string filename = name + ".dat";
+    string filename = OutputFileName(name, "dat");
     ofstream out(filename.c_str());
     if (!out)
         throw ("Cannot open " + filename + " for writing");
@@ -411,30 +632,31 @@ void ModuleType::WriteDat(const string &name) {
 
     map<int, Region>::iterator ri = regions.begin();
 
-    if (argRead.debugBits & debug::buckets)
+    if (debug::On(debug::buckets))
         dout << "\n*** Buckets ***\n";
 
-    for (map<int, list<TreeNode *> >::iterator bi = buckets.begin(); bi != buckets.end(); ++bi) {
+    PartitionTree &tree = partitionTree;
+    for (map<int, list<int> >::iterator bi = buckets.begin(); bi != buckets.end(); ++bi) {
         //calculate actual values
         int num = 0;
         double bSum = 0, tSum = 0, iSum = 0, oSum = 0, gSum = 0;
 
-        for (list<TreeNode *>::iterator mi = bi->second.begin(); mi != bi->second.end(); ++mi) {
+        for (list<int>::iterator mi = bi->second.begin(); mi != bi->second.end(); ++mi) {
             ++num;
-            bSum += log(double((*mi)->Size()));
+            bSum += log(double(tree.area[*mi]));
 
-            if (argRead.debugBits & debug::buckets)
-                dout << stringPrintf("%10d %10d\n", (*mi)->Size(), (*mi)->NumTerminals());
+            if (debug::On(debug::buckets))
+                dout << stringPrintf("%10d %10d\n", tree.area[*mi], tree.NumTerminals(*mi));
 
-            tSum += (*mi)->NumTerminals();
-            iSum += (*mi)->NumInputs();
-            oSum += (*mi)->NumOutputs();
-            gSum += (*mi)->GFraction();
+            tSum += tree.NumTerminals(*mi);
+            iSum += tree.numInputs[*mi];
+            oSum += tree.numOutputs[*mi];
+            gSum += tree.GFraction(*mi);
         }
         double B = exp(bSum / num), T = double(tSum) / num, I = double(iSum) / num, O = double(oSum) / num, g =
                 double(gSum) / num;
 
-        if (argRead.debugBits & debug::buckets) {
+        if (debug::On(debug::buckets)) {
             dout << "-------------------------------------------\n";
             dout << stringPrintf("%10.3f %10.3f\n\n", B, T);
         }
@@ -442,10 +664,10 @@ void ModuleType::WriteDat(const string &name) {
         double sdevT = -1, sdevG = -1;
         if (num > 1) {
             double sqDivTSum = 0, sqDivGSum = 0;
-            for (list<TreeNode *>::iterator mi = bi->second.begin(); mi != bi->second.end(); ++mi) {
-                double div = (*mi)->NumTerminals() - T;
+            for (list<int>::iterator mi = bi->second.begin(); mi != bi->second.end(); ++mi) {
+                double div = tree.NumTerminals(*mi) - T;
                 sqDivTSum += div * div;
-                div = (*mi)->GFraction() - g;
+                div = tree.GFraction(*mi) - g;
                 sqDivGSum += div * div;
             }
             sdevT = sqrt(sqDivTSum / (num - 1));
@@ -518,12 +740,6 @@ void ModuleType::WriteDatWord(ofstream &out, double v, bool g) {
     out << buf;
 }
 
-void ModuleType::CompoundNode::AddRtdData(map<int, map<int, int> > &rtd) {
-    ++(rtd[area][numInputs + numOutputs]);
-    left->AddRtdData(rtd);
-    right->AddRtdData(rtd);
-}
-
 void ModuleType::FillBuckets() {
     if (buckets.size() != 0)
         return;
@@ -531,18 +747,10 @@ void ModuleType::FillBuckets() {
     if (forrest.size() != 1)
         throw ("Internal error: forrest is not a tree");
 
-    forrest.begin()->second->FillBucketsWithTree(buckets);
-    buckets[buckets.rbegin()->first + 1].push_back(forrest.begin()->second);
-}
-
-void ModuleType::TreeNode::FillBucketsWithTree(map<int, list<TreeNode *> > &buckets) {
-    buckets[int(log(double(Size())) / log(1.9))].push_back(this);
-}
-
-void ModuleType::CompoundNode::FillBucketsWithTree(map<int, list<TreeNode *> > &buckets) {
-    TreeNode::FillBucketsWithTree(buckets);
-    left->FillBucketsWithTree(buckets);
-    right->FillBucketsWithTree(buckets);
+    for (int node = 0; node < partitionTree.Size(); ++node)
+        buckets[int(log(double(partitionTree.area[node])) / log(1.9))].push_back(node);
+    //the root, node 0, also gets a bucket of its own
+    buckets[buckets.rbegin()->first + 1].push_back(0);
 }
 
 void ModuleType::WriteRegions(ofstream &out, string prefix) {